@@ -24,11 +24,33 @@
  * Select integer length.
  * If the value is 0, use an integer of type int, use a long
  * integer type when the value is 1, and use a long long integer
- * type when the value is 2.
+ * type when the value is 2. BE_USE_NAN_BOXING requires 0.
  * default: 2
  */
 #define BE_INTGER_TYPE                  2
 
+/* Macro: BE_USE_NAN_BOXING
+ * Pack the type and the value of a berry value into 8 bytes by
+ * storing non-real values in the unused NaN space of a double.
+ * It halves the size of stack slots, list elements and map
+ * nodes, but requires BE_SINGLE_FLOAT 0 and a 64-bit target
+ * whose object addresses fit in 47 bits (such as x86-64 user
+ * space).
+ * This is a 32-bit integer mode: the integers are stored in the
+ * NaN space and never boxed, so BE_INTGER_TYPE must be set to 0
+ * and the integer values are limited to the range of int, the
+ * same as in the other builds with int integers.
+ * Two real values cannot be stored as is, and they are changed
+ * when they are stored (see tests/nanbox.be):
+ * - the positive subnormal numbers have the bits of the native
+ *   function pointers, they are flushed to 0 (the negative ones
+ *   are kept).
+ * - the NaNs having the sign bit set or a payload are replaced
+ *   by the canonical quiet NaN.
+ * default: 0
+ **/
+#define BE_USE_NAN_BOXING               0
+
 /* Macro: BE_USE_PRECOMPILED_OBJECT
  * Use precompiled objects to avoid creating these objects at
  * runtime. Enable this macro can greatly optimize RAM usage.
@@ -54,8 +76,50 @@
  **/
 #define BE_DEBUG_DUMP_LEVEL             2
 
+/* Macro: BE_USE_COMPUTED_GOTO
+ * Use the "labels as values" extension of GCC (and Clang) to
+ * dispatch virtual machine instructions (threaded code), which is
+ * faster than the switch statement. The switch statement is used
+ * when the value is 0 or the compiler does not support it.
+ * default: 1
+ **/
+#ifndef BE_USE_COMPUTED_GOTO
+#define BE_USE_COMPUTED_GOTO            1
+#endif
+
+/* Macro: BE_USE_JIT
+ * Compile hot functions to native code with the baseline JIT
+ * compiler, which stitches machine code templates of the supported
+ * instructions and returns to the interpreter for the others. It
+ * is only available on x86-64 Linux (it is disabled on the other
+ * targets) and requires BE_USE_NAN_BOXING 0, BE_INTGER_TYPE 2 and
+ * BE_SINGLE_FLOAT 0.
+ * default: 0
+ **/
+#ifndef BE_USE_JIT
+#define BE_USE_JIT                      0
+#endif
+
+/* Macro: BE_JIT_HOT_COUNT
+ * The number of calls and loop back edges after which a function
+ * is compiled by the JIT compiler.
+ * default: 1000
+ **/
+#ifndef BE_JIT_HOT_COUNT
+#define BE_JIT_HOT_COUNT                1000
+#endif
+
+/* Macro: BE_JIT_PERF_MAP
+ * Write the address of each compiled function to the file
+ * /tmp/perf-PID.map, so that the Linux perf tool can symbolize it.
+ * default: 1
+ **/
+#define BE_JIT_PERF_MAP                 1
+
 /* Macro: BE_STACK_TOTAL_MAX
- * Set the maximum total stack size.
+ * Set the default maximum total stack size of a VM. The stack
+ * grows on demand up to this size, and the limit of each VM can
+ * be changed by be_setstacklimit().
  * default: 2000
  **/
 #define BE_STACK_TOTAL_MAX              2000
@@ -76,6 +140,56 @@
  **/
 #define BE_STR_HASH_CACHE               0
 
+/* Macro: BE_GC_STEP_SIZE
+ * The amount of work of an incremental GC step. While a collection
+ * cycle is running, a step is done at each allocation of a GC
+ * object, so the pause time of the GC is bounded by this size. The
+ * collection runs without interruption when the value is 0.
+ * default: 1000
+ **/
+#define BE_GC_STEP_SIZE                 1000
+
+/* Macro: BE_GC_GENERATIONAL
+ * Use the generational mode of the GC when the value is true. The
+ * minor collections only mark and sweep the young objects, and the
+ * objects survived BE_GC_PROMOTE_AGE minor collections become old,
+ * which are only collected by the major collections. The collections
+ * are not incremental in this mode.
+ * default: 0
+ **/
+#ifndef BE_GC_GENERATIONAL
+#define BE_GC_GENERATIONAL              0
+#endif
+
+/* Macro: BE_GC_PROMOTE_AGE
+ * The number of minor collections a young object must survive to
+ * become old in the generational mode, the range is 1 to 7.
+ * default: 2
+ **/
+#define BE_GC_PROMOTE_AGE               2
+
+/* Macro: BE_USE_MEM_POOL
+ * Allocate the memory blocks of up to 256 bytes (most GC objects, short
+ * strings and small buffers) from the memory pool of the VM. The pool
+ * divides the slabs into blocks of the same size class and keeps a
+ * free list for each slab, the larger blocks are allocated by the
+ * system allocator. The small GC objects and the short strings have
+ * their own slabs (the GC pages), whose marks are kept in bitmaps, so
+ * the GC sweeps the pages instead of an object set or the string
+ * table. The empty slabs are reused by all size classes, and are
+ * returned to the system allocator in chunks of 16 slabs.
+ * default: 1
+ **/
+#define BE_USE_MEM_POOL                 1
+
+/* Macro: BE_MEM_SLAB_SIZE
+ * The size of the slabs of the memory pool in bytes. The slabs are
+ * aligned on their size, so the value must be a power of 2, and it
+ * must be at least 1024.
+ * default: 4096
+ **/
+#define BE_MEM_SLAB_SIZE                4096
+
 /*
  * Macro: BE_USE_FILE_SYSTEM
  * The file system interface will be used when this macro is true
@@ -0,0 +1,95 @@
+extern const bcstring be_const_str_insert;
+extern const bcstring be_const_str_lower;
+extern const bcstring be_const_str_var;
+extern const bcstring be_const_str_dump;
+extern const bcstring be_const_str_print;
+extern const bcstring be_const_str_tan;
+extern const bcstring be_const_str_getcwd;
+extern const bcstring be_const_str_log;
+extern const bcstring be_const_str_sinh;
+extern const bcstring be_const_str_elif;
+extern const bcstring be_const_str_setrange;
+extern const bcstring be_const_str___iterator__;
+extern const bcstring be_const_str_isfile;
+extern const bcstring be_const_str_pow;
+extern const bcstring be_const_str_classof;
+extern const bcstring be_const_str_pi;
+extern const bcstring be_const_str_remove;
+extern const bcstring be_const_str_abs;
+extern const bcstring be_const_str_upper;
+extern const bcstring be_const_str_codedump;
+extern const bcstring be_const_str_compile;
+extern const bcstring be_const_str_log10;
+extern const bcstring be_const_str_rad;
+extern const bcstring be_const_str_classname;
+extern const bcstring be_const_str_listdir;
+extern const bcstring be_const_str_size;
+extern const bcstring be_const_str_else;
+extern const bcstring be_const_str_init;
+extern const bcstring be_const_str_srand;
+extern const bcstring be_const_str___hasnext__;
+extern const bcstring be_const_str_cosh;
+extern const bcstring be_const_str_exp;
+extern const bcstring be_const_str_number;
+extern const bcstring be_const_str_range;
+extern const bcstring be_const_str_system;
+extern const bcstring be_const_str_false;
+extern const bcstring be_const_str_floor;
+extern const bcstring be_const_str_real;
+extern const bcstring be_const_str_cos;
+extern const bcstring be_const_str_deinit;
+extern const bcstring be_const_str_int;
+extern const bcstring be_const_str_splitext;
+extern const bcstring be_const_str_do;
+extern const bcstring be_const_str_append;
+extern const bcstring be_const_str_clock;
+extern const bcstring be_const_str_open;
+extern const bcstring be_const_str_for;
+extern const bcstring be_const_str_load;
+extern const bcstring be_const_str_memcount;
+extern const bcstring be_const_str_tanh;
+extern const bcstring be_const_str_def;
+extern const bcstring be_const_str_sin;
+extern const bcstring be_const_str_tostring;
+extern const bcstring be_const_str_if;
+extern const bcstring be_const_str___upper__;
+extern const bcstring be_const_str_exit;
+extern const bcstring be_const_str_iter;
+extern const bcstring be_const_str___lower__;
+extern const bcstring be_const_str_map;
+extern const bcstring be_const_str_type;
+extern const bcstring be_const_str_true;
+extern const bcstring be_const_str_assert;
+extern const bcstring be_const_str_path;
+extern const bcstring be_const_str_time;
+extern const bcstring be_const_str_continue;
+extern const bcstring be_const_str_atan;
+extern const bcstring be_const_str_dot_data;
+extern const bcstring be_const_str_sqrt;
+extern const bcstring be_const_str___next__;
+extern const bcstring be_const_str_ceil;
+extern const bcstring be_const_str_isdir;
+extern const bcstring be_const_str_item;
+extern const bcstring be_const_str_mkdir;
+extern const bcstring be_const_str_nil;
+extern const bcstring be_const_str_;
+extern const bcstring be_const_str_acos;
+extern const bcstring be_const_str_deg;
+extern const bcstring be_const_str_input;
+extern const bcstring be_const_str_rand;
+extern const bcstring be_const_str_import;
+extern const bcstring be_const_str_while;
+extern const bcstring be_const_str_resize;
+extern const bcstring be_const_str_return;
+extern const bcstring be_const_str_asin;
+extern const bcstring be_const_str_format;
+extern const bcstring be_const_str_setitem;
+extern const bcstring be_const_str_str;
+extern const bcstring be_const_str_super;
+extern const bcstring be_const_str_break;
+extern const bcstring be_const_str_end;
+extern const bcstring be_const_str_chdir;
+extern const bcstring be_const_str_exists;
+extern const bcstring be_const_str_list;
+extern const bcstring be_const_str_as;
+extern const bcstring be_const_str_class;
@@ -0,0 +1,142 @@
+be_define_const_str(insert, "insert", 3332609576u, 0, 6, &be_const_str_lower);
+be_define_const_str(lower, "lower", 3038577850u, 0, 5, &be_const_str_var);
+be_define_const_str(var, "var", 2317739966u, 64, 3, NULL);
+be_define_const_str(dump, "dump", 3663001223u, 0, 4, NULL);
+be_define_const_str(print, "print", 372738696u, 0, 5, &be_const_str_tan);
+be_define_const_str(tan, "tan", 2633446552u, 0, 3, NULL);
+be_define_const_str(getcwd, "getcwd", 652026575u, 0, 6, &be_const_str_log);
+be_define_const_str(log, "log", 1062293841u, 0, 3, &be_const_str_sinh);
+be_define_const_str(sinh, "sinh", 282220607u, 0, 4, &be_const_str_elif);
+be_define_const_str(elif, "elif", 3232090307u, 51, 4, NULL);
+be_define_const_str(setrange, "setrange", 3794019032u, 0, 8, NULL);
+be_define_const_str(__iterator__, "__iterator__", 3884039703u, 0, 12, &be_const_str_isfile);
+be_define_const_str(isfile, "isfile", 3131505107u, 0, 6, &be_const_str_pow);
+be_define_const_str(pow, "pow", 1479764693u, 0, 3, NULL);
+be_define_const_str(classof, "classof", 1796577762u, 0, 7, &be_const_str_pi);
+be_define_const_str(pi, "pi", 1213090802u, 0, 2, NULL);
+be_define_const_str(remove, "remove", 3683784189u, 0, 6, NULL);
+be_define_const_str(abs, "abs", 709362235u, 0, 3, &be_const_str_upper);
+be_define_const_str(upper, "upper", 176974407u, 0, 5, NULL);
+be_define_const_str(codedump, "codedump", 1786337906u, 0, 8, &be_const_str_compile);
+be_define_const_str(compile, "compile", 1000265118u, 0, 7, &be_const_str_log10);
+be_define_const_str(log10, "log10", 2346846000u, 0, 5, &be_const_str_rad);
+be_define_const_str(rad, "rad", 1358899048u, 0, 3, NULL);
+be_define_const_str(classname, "classname", 1998589948u, 0, 9, &be_const_str_listdir);
+be_define_const_str(listdir, "listdir", 2005220720u, 0, 7, &be_const_str_size);
+be_define_const_str(size, "size", 597743964u, 0, 4, &be_const_str_else);
+be_define_const_str(else, "else", 3183434736u, 52, 4, NULL);
+be_define_const_str(init, "init", 380752755u, 0, 4, &be_const_str_srand);
+be_define_const_str(srand, "srand", 465518633u, 0, 5, NULL);
+be_define_const_str(__hasnext__, "__hasnext__", 2784591450u, 0, 11, &be_const_str_cosh);
+be_define_const_str(cosh, "cosh", 4099687964u, 0, 4, &be_const_str_exp);
+be_define_const_str(exp, "exp", 1923516200u, 0, 3, &be_const_str_number);
+be_define_const_str(number, "number", 467038368u, 0, 6, &be_const_str_range);
+be_define_const_str(range, "range", 4208725202u, 0, 5, &be_const_str_system);
+be_define_const_str(system, "system", 1226705564u, 0, 6, &be_const_str_false);
+be_define_const_str(false, "false", 184981848u, 62, 5, NULL);
+be_define_const_str(floor, "floor", 3102149661u, 0, 5, &be_const_str_real);
+be_define_const_str(real, "real", 3604983901u, 0, 4, NULL);
+be_define_const_str(cos, "cos", 4220379804u, 0, 3, &be_const_str_deinit);
+be_define_const_str(deinit, "deinit", 2345559592u, 0, 6, &be_const_str_int);
+be_define_const_str(int, "int", 2515107422u, 0, 3, &be_const_str_splitext);
+be_define_const_str(splitext, "splitext", 2150391934u, 0, 8, &be_const_str_do);
+be_define_const_str(do, "do", 1646057492u, 65, 2, NULL);
+be_define_const_str(append, "append", 110723809u, 0, 6, &be_const_str_clock);
+be_define_const_str(clock, "clock", 363073373u, 0, 5, &be_const_str_open);
+be_define_const_str(open, "open", 3546203337u, 0, 4, NULL);
+be_define_const_str(for, "for", 2901640080u, 54, 3, NULL);
+be_define_const_str(load, "load", 3859241449u, 0, 4, &be_const_str_memcount);
+be_define_const_str(memcount, "memcount", 2357861981u, 0, 8, NULL);
+be_define_const_str(tanh, "tanh", 153638352u, 0, 4, &be_const_str_def);
+be_define_const_str(def, "def", 3310976652u, 55, 3, NULL);
+be_define_const_str(sin, "sin", 3761252941u, 0, 3, &be_const_str_tostring);
+be_define_const_str(tostring, "tostring", 2299708645u, 0, 8, NULL);
+be_define_const_str(if, "if", 959999494u, 50, 2, NULL);
+be_define_const_str(__upper__, "__upper__", 3612202883u, 0, 9, &be_const_str_exit);
+be_define_const_str(exit, "exit", 3454868101u, 0, 4, &be_const_str_iter);
+be_define_const_str(iter, "iter", 3124256359u, 0, 4, NULL);
+be_define_const_str(__lower__, "__lower__", 123855590u, 0, 9, NULL);
+be_define_const_str(map, "map", 3751997361u, 0, 3, &be_const_str_type);
+be_define_const_str(type, "type", 1361572173u, 0, 4, &be_const_str_true);
+be_define_const_str(true, "true", 1303515621u, 61, 4, NULL);
+be_define_const_str(assert, "assert", 2774883451u, 0, 6, NULL);
+be_define_const_str(path, "path", 2223459638u, 0, 4, &be_const_str_time);
+be_define_const_str(time, "time", 1564253156u, 0, 4, &be_const_str_continue);
+be_define_const_str(continue, "continue", 2977070660u, 59, 8, NULL);
+be_define_const_str(atan, "atan", 108579519u, 0, 4, &be_const_str_dot_data);
+be_define_const_str(dot_data, ".data", 1880857985u, 0, 5, &be_const_str_sqrt);
+be_define_const_str(sqrt, "sqrt", 2112764879u, 0, 4, NULL);
+be_define_const_str(__next__, "__next__", 640563104u, 0, 8, &be_const_str_ceil);
+be_define_const_str(ceil, "ceil", 1659167240u, 0, 4, &be_const_str_isdir);
+be_define_const_str(isdir, "isdir", 2340917412u, 0, 5, &be_const_str_item);
+be_define_const_str(item, "item", 2671260646u, 0, 4, &be_const_str_mkdir);
+be_define_const_str(mkdir, "mkdir", 2883839448u, 0, 5, &be_const_str_nil);
+be_define_const_str(nil, "nil", 228849900u, 63, 3, NULL);
+be_define_const_str(, "", 2166136261u, 0, 0, &be_const_str_acos);
+be_define_const_str(acos, "acos", 1006755615u, 0, 4, &be_const_str_deg);
+be_define_const_str(deg, "deg", 3327754271u, 0, 3, &be_const_str_input);
+be_define_const_str(input, "input", 4191711099u, 0, 5, NULL);
+be_define_const_str(rand, "rand", 2711325910u, 0, 4, &be_const_str_import);
+be_define_const_str(import, "import", 288002260u, 66, 6, &be_const_str_while);
+be_define_const_str(while, "while", 231090382u, 53, 5, NULL);
+be_define_const_str(resize, "resize", 3514612129u, 0, 6, &be_const_str_return);
+be_define_const_str(return, "return", 2246981567u, 60, 6, NULL);
+be_define_const_str(asin, "asin", 4272848550u, 0, 4, &be_const_str_format);
+be_define_const_str(format, "format", 3114108242u, 0, 6, &be_const_str_setitem);
+be_define_const_str(setitem, "setitem", 1554834596u, 0, 7, &be_const_str_str);
+be_define_const_str(str, "str", 3259748752u, 0, 3, &be_const_str_super);
+be_define_const_str(super, "super", 4152230356u, 0, 5, &be_const_str_break);
+be_define_const_str(break, "break", 3378807160u, 58, 5, &be_const_str_end);
+be_define_const_str(end, "end", 1787721130u, 56, 3, NULL);
+be_define_const_str(chdir, "chdir", 806634853u, 0, 5, &be_const_str_exists);
+be_define_const_str(exists, "exists", 1002329533u, 0, 6, &be_const_str_list);
+be_define_const_str(list, "list", 217798785u, 0, 4, &be_const_str_as);
+be_define_const_str(as, "as", 1579491469u, 67, 2, &be_const_str_class);
+be_define_const_str(class, "class", 2872970239u, 57, 5, NULL);
+
+static const bstring* const m_string_table[] = {
+    (const bstring *)&be_const_str_insert,
+    (const bstring *)&be_const_str_dump,
+    (const bstring *)&be_const_str_print,
+    (const bstring *)&be_const_str_getcwd,
+    (const bstring *)&be_const_str_setrange,
+    (const bstring *)&be_const_str___iterator__,
+    (const bstring *)&be_const_str_classof,
+    (const bstring *)&be_const_str_remove,
+    NULL,
+    (const bstring *)&be_const_str_abs,
+    (const bstring *)&be_const_str_codedump,
+    NULL,
+    (const bstring *)&be_const_str_classname,
+    (const bstring *)&be_const_str_init,
+    (const bstring *)&be_const_str___hasnext__,
+    (const bstring *)&be_const_str_floor,
+    (const bstring *)&be_const_str_cos,
+    (const bstring *)&be_const_str_append,
+    (const bstring *)&be_const_str_for,
+    (const bstring *)&be_const_str_load,
+    (const bstring *)&be_const_str_tanh,
+    (const bstring *)&be_const_str_sin,
+    (const bstring *)&be_const_str_if,
+    (const bstring *)&be_const_str___upper__,
+    (const bstring *)&be_const_str___lower__,
+    (const bstring *)&be_const_str_map,
+    NULL,
+    (const bstring *)&be_const_str_assert,
+    (const bstring *)&be_const_str_path,
+    (const bstring *)&be_const_str_atan,
+    (const bstring *)&be_const_str___next__,
+    (const bstring *)&be_const_str_,
+    (const bstring *)&be_const_str_rand,
+    (const bstring *)&be_const_str_resize,
+    (const bstring *)&be_const_str_asin,
+    NULL,
+    NULL,
+    (const bstring *)&be_const_str_chdir
+};
+
+static const struct bconststrtab m_const_string_table = {
+    .size = 38,
+    .count = 77,
+    .table = m_string_table
+};
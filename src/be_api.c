@@ -10,9 +10,11 @@
 #include "be_debug.h"
 #include "be_exec.h"
 #include "be_strlib.h"
+#include "be_gc.h"
 #include <string.h>
 
-#define retreg(vm)      ((vm)->cf->func)
+/* the result of a light native function is stored in argv[-1] */
+#define retreg(vm)      (be_inlightcall(vm) ? (vm)->reg - 1 : (vm)->cf->func)
 
 static bvalue* index2value(bvm *vm, int idx)
 {
@@ -31,6 +33,8 @@ static void class_init(bvm *vm, bclass *c, const bnfuncinfo *lib)
         bstring *s = be_newstr(vm, lib->name);
         if (lib->function) { /* method */
             be_prim_method_bind(vm, c, s, lib->function);
+        } else if (lib->lfunction) { /* light method */
+            be_prim_lmethod_bind(vm, c, s, lib->lfunction);
         } else {
             be_member_bind(vm, c, s); /* member */
         }
@@ -39,9 +43,10 @@ static void class_init(bvm *vm, bclass *c, const bnfuncinfo *lib)
     be_map_release(vm, c->members); /* clear space */
 }
 
-void be_regfunc(bvm *vm, const char *name, bntvfunc f)
+/* get the variable of the new function 'name', or NULL if the name
+ * is already registered */
+static bvalue* regvar(bvm *vm, const char *name)
 {
-    bvalue *var;
     bstring *s = be_newstr(vm, name);
 #if !BE_USE_PRECOMPILED_OBJECT
     int idx = be_builtin_find(vm, s);
@@ -54,9 +59,25 @@ void be_regfunc(bvm *vm, const char *name, bntvfunc f)
     if (idx < be_builtin_count(vm)) { /* new function */
         idx = be_global_new(vm, s);
 #endif
-        var = be_global_var(vm, idx);
+        return be_global_var(vm, idx);
+    }
+    return NULL; /* error case, do nothing */
+}
+
+void be_regfunc(bvm *vm, const char *name, bntvfunc f)
+{
+    bvalue *var = regvar(vm, name);
+    if (var) {
         var_setntvfunc(var, f);
-    } /* error case, do nothing */
+    }
+}
+
+void be_reglfunc(bvm *vm, const char *name, blntvfunc f)
+{
+    bvalue *var = regvar(vm, name);
+    if (var) {
+        var_setlntvfunc(var, f);
+    }
 }
 
 void be_regclass(bvm *vm, const char *name, const bnfuncinfo *lib)
@@ -322,6 +343,12 @@ void be_pushntvfunction(bvm *vm, bntvfunc f)
     var_setntvfunc(top, f);
 }
 
+void be_pushlntvfunction(bvm *vm, blntvfunc f)
+{
+    bvalue *top = be_incrtop(vm);
+    var_setlntvfunc(top, f);
+}
+
 void be_pushclass(bvm *vm, const char *name, const bnfuncinfo *lib)
 {
     bclass *c;
@@ -456,7 +483,7 @@ int be_setmember(bvm *vm, int index, const char *k)
     if (var_isinstance(o)) {
         bvalue *v = index2value(vm, -1);
         binstance *obj = var_toobj(o);
-        res = be_instance_setmember(obj, be_newstr(vm, k), v);
+        res = be_instance_setmember(vm, obj, be_newstr(vm, k), v);
     }
     return res != BE_NIL;
 }
@@ -527,9 +554,9 @@ int be_setindex(bvm *vm, int index)
     case BE_LIST:
         if (var_isint(k)) {
             blist *list = cast(blist*, var_toobj(o));
-            int idx = var_toidx(k);
-            if (idx < be_list_count(list)) {
-                bvalue *dst = be_list_at(list, idx);
+            bvalue *dst = be_list_index(list, var_toidx(k));
+            if (dst) {
+                be_gc_barrier(vm, list);
                 var_setval(dst, v);
                 return btrue;
             }
@@ -540,6 +567,7 @@ int be_setindex(bvm *vm, int index)
             bmap *map = cast(bmap*, var_toobj(o));
             bvalue *dst = be_map_find(map, k);
             if (dst) {
+                be_gc_barrier(vm, map);
                 var_setval(dst, v);
                 return btrue;
             }
@@ -571,6 +599,7 @@ void be_setupval(bvm *vm, int index, int pos)
     if (var_istype(f, BE_NTVCLOS)) {
         bntvclos *nf = var_toobj(f);
         bvalue *uv = be_ntvclos_upval(nf, pos)->value;
+        be_gc_barrier(vm, nf);
         var_setval(uv, v);
     }
 }
@@ -792,12 +821,14 @@ void be_call(bvm *vm, int argc)
     bvalue *fval = vm->top - argc - 1;
     be_assert(fval >= vm->reg);
     be_dofunc(vm, fval, argc);
+    be_stack_shrink(vm);
 }
 
 int be_pcall(bvm *vm, int argc)
 {
     bvalue *f = vm->top - argc - 1;
     int res = be_protectedcall(vm, f, argc);
+    be_stack_shrink(vm);
     return res;
 }
 
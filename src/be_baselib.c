@@ -1,4 +1,7 @@
 #include "be_object.h"
+#include "be_class.h"
+#include "be_string.h"
+#include "be_strlib.h"
 #include "be_mem.h"
 #include <string.h>
 
@@ -91,83 +94,89 @@ static int l_super(bvm *vm)
     be_return_nil(vm);
 }
 
-static int l_type(bvm *vm)
+/* the light builtins read the arguments from argv and store the result
+ * in argv[-1], the stack API is only used to call methods */
+static int l_type(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm)) {
-        be_pushstring(vm, be_typename(vm, 1));
-        be_return(vm);
+    if (argc) {
+        var_setstr(argv - 1, be_newstr(vm, be_vtype2str(argv)));
+    } else {
+        var_setnil(argv - 1);
     }
-    be_return_nil(vm);
+    return 0;
 }
 
-static int l_classname(bvm *vm)
+static int l_classname(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm)) {
-        const char *t = be_classname(vm, 1);
-        if (t) {
-            be_pushstring(vm, t);
-            be_return(vm);
-        }
+    bvalue *ret = argv - 1;
+    (void)vm;
+    if (argc && var_isclass(argv)) {
+        var_setstr(ret, be_class_name(cast(bclass*, var_toobj(argv))));
+    } else if (argc && var_isinstance(argv)) {
+        var_setstr(ret, be_instance_name(cast(binstance*, var_toobj(argv))));
+    } else {
+        var_setnil(ret);
     }
-    be_return_nil(vm);
+    return 0;
 }
 
-static int l_classof(bvm *vm)
+static int l_classof(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm) && !be_classof(vm, 1)) {
-        be_return(vm);
+    bvalue *ret = argv - 1;
+    (void)vm;
+    if (argc && var_isinstance(argv)) {
+        binstance *obj = var_toobj(argv);
+        var_setclass(ret, be_instance_class(obj));
+    } else {
+        var_setnil(ret);
     }
-    be_return_nil(vm);
+    return 0;
 }
 
-static int l_number(bvm *vm)
+static int l_number(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm)) {
-        if (be_isstring(vm, 1)) {
-            be_str2num(vm, be_tostring(vm, 1));
-            be_return(vm);
-        } else if (be_isnumber(vm, 1)) {
-            be_pushvalue(vm, 1);
-            be_return(vm);
-        }
+    if (argc && var_isstr(argv)) {
+        be_str2num(vm, str(var_tostr(argv)));
+        be_return(vm);
     }
-    be_return_nil(vm);
+    if (argc && var_isnumber(argv)) {
+        var_setval(argv - 1, argv);
+    } else {
+        var_setnil(argv - 1);
+    }
+    return 0;
 }
 
-static int l_int(bvm *vm)
+static int l_int(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm)) {
-        if (be_isstring(vm, 1)) {
-            const char *s = be_tostring(vm, 1);
-            be_pushint(vm, be_str2int(s, NULL));
-        } else if (be_isreal(vm, 1)) {
-            be_pushint(vm, (bint)be_toreal(vm, 1));
-        } else if (be_isint(vm, 1)) {
-            be_pushvalue(vm, 1);
-        } else {
-            be_return_nil(vm);
-        }
-        be_return(vm);
+    bvalue *ret = argv - 1;
+    (void)vm;
+    if (argc && var_isstr(argv)) {
+        var_setint(ret, be_str2int(str(var_tostr(argv)), NULL));
+    } else if (argc && var_isreal(argv)) {
+        var_setint(ret, (bint)var_toreal(argv));
+    } else if (argc && var_isint(argv)) {
+        var_setval(ret, argv);
+    } else {
+        var_setnil(ret);
     }
-    be_return_nil(vm);
+    return 0;
 }
 
-static int l_real(bvm *vm)
+static int l_real(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm)) {
-        if (be_isstring(vm, 1)) {
-            const char *s = be_tostring(vm, 1);
-            be_pushreal(vm, be_str2real(s, NULL));
-        } else if (be_isint(vm, 1)) {
-            be_pushreal(vm, (breal)be_toint(vm, 1));
-        } else if (be_isreal(vm, 1)) {
-            be_pushvalue(vm, 1);
-        } else {
-            be_return_nil(vm);
-        }
-        be_return(vm);
+    bvalue *ret = argv - 1;
+    (void)vm;
+    if (argc && var_isstr(argv)) {
+        var_setreal(ret, be_str2real(str(var_tostr(argv)), NULL));
+    } else if (argc && var_isint(argv)) {
+        var_setreal(ret, (breal)var_toint(argv));
+    } else if (argc && var_isreal(argv)) {
+        var_setval(ret, argv);
+    } else {
+        var_setnil(ret);
     }
-    be_return_nil(vm);
+    return 0;
 }
 
 static int check_method(bvm *vm, const char *attr)
@@ -210,21 +219,26 @@ static int l_next(bvm *vm)
     be_return_nil(vm);
 }
 
-static int l_str(bvm *vm)
+static int l_str(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm)) {
+    if (!argc) {
+        var_setstr(argv - 1, be_newstr(vm, ""));
+    } else if (var_isstr(argv)) {
+        var_setval(argv - 1, argv);
+    } else if (var_isnumber(argv)) {
+        var_setstr(argv - 1, be_num2str(vm, argv));
+    } else { /* may call the tostring() method of the instances */
         be_tostring(vm, 1);
-    } else {
-        be_pushstring(vm, "");
+        be_return(vm);
     }
-    be_return(vm);
+    return 0;
 }
 
-static int l_size(bvm *vm)
+static int l_size(bvm *vm, bvalue *argv, int argc)
 {
-    if (be_top(vm) && be_isstring(vm, 1)) {
-        be_pushint(vm, be_strlen(vm, 1));
-        be_return(vm);
+    if (argc && var_isstr(argv)) {
+        var_setint(argv - 1, str_len(var_tostr(argv)));
+        return 0;
     }
     if (check_method(vm, "size")) {
         be_pushvalue(vm, 1);
@@ -291,14 +305,14 @@ void be_load_baselib(bvm *vm)
     be_regfunc(vm, "exit", l_exit);
     be_regfunc(vm, "super", l_super);
     be_regfunc(vm, "memcount", l_memcount);
-    be_regfunc(vm, "type", l_type);
-    be_regfunc(vm, "classname", l_classname);
-    be_regfunc(vm, "classof", l_classof);
-    be_regfunc(vm, "number", l_number);
-    be_regfunc(vm, "str", l_str);
-    be_regfunc(vm, "int", l_int);
-    be_regfunc(vm, "real", l_real);
-    be_regfunc(vm, "size", l_size);
+    be_reglfunc(vm, "type", l_type);
+    be_reglfunc(vm, "classname", l_classname);
+    be_reglfunc(vm, "classof", l_classof);
+    be_reglfunc(vm, "number", l_number);
+    be_reglfunc(vm, "str", l_str);
+    be_reglfunc(vm, "int", l_int);
+    be_reglfunc(vm, "real", l_real);
+    be_reglfunc(vm, "size", l_size);
     be_regfunc(vm, "compile", l_compile);
     be_regfunc(vm, "codedump", l_codedump);
     be_regfunc(vm, "__iterator__", l_iterator);
@@ -318,14 +332,14 @@ vartab m_builtin (scope: local) {
     exit, func(l_exit)
     super, func(l_super)
     memcount, func(l_memcount)
-    type, func(l_type)
-    classname, func(l_classname)
-    classof, func(l_classof)
-    number, func(l_number)
-    str, func(l_str)
-    int, func(l_int)
-    real, func(l_real)
-    size, func(l_size)
+    type, lfunc(l_type)
+    classname, lfunc(l_classname)
+    classof, lfunc(l_classof)
+    number, lfunc(l_number)
+    str, lfunc(l_str)
+    int, lfunc(l_int)
+    real, lfunc(l_real)
+    size, lfunc(l_size)
     compile, func(l_compile)
     codedump, func(l_codedump)
     __iterator__, func(l_iterator)
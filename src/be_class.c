@@ -7,6 +7,38 @@
 #include "be_vm.h"
 #include "be_func.h"
 #include "be_var.h"
+#include "be_mem.h"
+
+/* the class members or its superclass changed, the class gets a new
+ * stamp that is greater than all the stamps seen by the caches */
+#define class_changed(vm, c)    ((c)->version = ++(vm)->classver)
+
+/* the instances of the classes having 'deinit' are finalized by the GC,
+ * so the class records it when the method is bound */
+static void method_changed(bvm *vm, bclass *c, bstring *name)
+{
+    if (name == vm->opnames[OM_DEINIT]) {
+        c->hasdeinit = 1;
+    }
+    class_changed(vm, c);
+}
+
+void be_opmethod_init(bvm *vm)
+{
+    static const char *const names[] = { /* order of bopmethod */
+        "+", "-", "*", "/", "%", "<", "<=", "==", "!=", ">", ">=",
+        "&", "|", "^", "<<", ">>", "-*", "~", "tobool", "item",
+        "setitem", "iter", "hasnext", "next", "init", "deinit"
+    };
+    int i;
+    be_assert(array_count(names) == OM_COUNT);
+    for (i = 0; i < OM_COUNT; ++i) {
+        bstring *s = be_newstr(vm, names[i]);
+        be_gc_fix(vm, gc_object(s));
+        vm->opnames[i] = s;
+    }
+    vm->classver = 0;
+}
 
 bclass* be_newclass(bvm *vm, bstring *name, bclass *super)
 {
@@ -18,13 +50,37 @@ bclass* be_newclass(bvm *vm, bstring *name, bclass *super)
         obj->super = super;
         obj->members = NULL; /* gc protection */
         obj->nvar = 0;
+        obj->hasdeinit = super ? super->hasdeinit : 0;
+        obj->version = 0;
         obj->name = name;
+        obj->opcache = NULL;
         obj->members = be_map_new(vm);
+        be_gc_barrier(vm, obj);
     }
     be_stackpop(vm, 1);
     return obj;
 }
 
+void be_class_setsuper(bvm *vm, bclass *c, bclass *super)
+{
+    if (c->super != super) {
+        bvalue *v = be_map_findstr(c->members, vm->opnames[OM_DEINIT]);
+        be_gc_barrier(vm, c);
+        c->super = super;
+        c->hasdeinit = (v && basetype(var_type(v)) == BE_FUNCTION)
+            || (super && super->hasdeinit);
+        class_changed(vm, c);
+    }
+}
+
+void be_class_free(bvm *vm, bclass *c)
+{
+    if (c->opcache) {
+        be_free(vm, c->opcache, sizeof(bopcache));
+    }
+    be_free(vm, c, sizeof(bclass));
+}
+
 int be_class_attribute(bclass *c, bstring *attr)
 {
     while (c) {
@@ -41,24 +97,82 @@ void be_member_bind(bvm *vm, bclass *c, bstring *name)
 {
     bmap *map = c->members;
     bvalue *v = be_map_insertstr(vm, map, name, NULL);
-    v->v.i = c->nvar++;
-    v->type = MT_VARIABLE;
+    var_setint(v, c->nvar++);
+    class_changed(vm, c);
 }
 
 void be_method_bind(bvm *vm, bclass *c, bstring *name, bproto *p)
 {
-    bvalue *m = be_map_insertstr(vm, c->members, name, NULL);
+    /* the closure is created first, since the map must not be scanned
+     * between the insertion and the assignment */
     bclosure *cl = be_newclosure(vm, 0);
+    bvalue *m = be_map_insertstr(vm, c->members, name, NULL);
     cl->proto = p;
-    m->v.p = cl;
-    m->type = MT_METHOD;
+    var_setclosure(m, cl);
+    method_changed(vm, c, name);
 }
 
 void be_prim_method_bind(bvm *vm, bclass *c, bstring *name, bntvfunc f)
 {
     bvalue *m = be_map_insertstr(vm, c->members, name, NULL);
-    m->v.nf = f;
-    m->type = MT_PRIMMETHOD;
+    var_setntvfunc(m, f);
+    method_changed(vm, c, name);
+}
+
+void be_prim_lmethod_bind(bvm *vm, bclass *c, bstring *name, blntvfunc f)
+{
+    bvalue *m = be_map_insertstr(vm, c->members, name, NULL);
+    var_setlntvfunc(m, f);
+    method_changed(vm, c, name);
+}
+
+/* find the member of the class, the result is the inheritance depth
+ * of the class owning the member, or -1 if the member is not found */
+int be_class_member(bclass *c, bstring *name, bvalue *dst)
+{
+    int depth;
+    for (depth = 0; c; c = c->super, ++depth) {
+        bvalue *v = be_map_findstr(c->members, name);
+        if (v) {
+            *dst = *v;
+            return depth;
+        }
+    }
+    var_setnil(dst);
+    return -1;
+}
+
+/* the version of the class chain up to the inheritance depth (the whole
+ * chain if depth is negative), i.e. the greatest stamp of the classes.
+ * a lookup in these classes is out of date once the version changed */
+unsigned int be_class_version(bclass *c, int depth)
+{
+    unsigned int version = 0;
+    for (; c; c = c->super) {
+        if (c->version > version) {
+            version = c->version;
+        }
+        if (depth-- == 0) {
+            break;
+        }
+    }
+    return version;
+}
+
+/* get the super-instance of the inheritance depth. the instances created
+ * before be_class_setsuper() changed their class chain keep the old
+ * chain, the result is NULL if the two chains differ up to the depth */
+binstance* be_instance_base(binstance *obj, int depth)
+{
+    bclass *c = obj->class;
+    while (depth--) {
+        obj = obj->super;
+        c = c->super;
+        if (obj == NULL || obj->class != c) {
+            return NULL;
+        }
+    }
+    return obj;
 }
 
 binstance* instance_member(binstance *obj, bstring *name, bvalue *dst)
@@ -86,6 +200,7 @@ static binstance* newobjself(bvm *vm, bclass *c)
         while (v < end) { var_setnil(v); ++v; }
         obj->class = c;
         obj->super = NULL;
+        obj->nvar = c->nvar;
     }
     return obj;
 }
@@ -98,8 +213,14 @@ static binstance* newobject(bvm *vm, bclass *c)
     obj = prev = newobjself(vm, c);
     var_setinstance(buf, obj);
     for (c = c->super; c; c = c->super) {
-        prev->super = newobjself(vm, c);
-        prev = prev->super;
+        binstance *super = newobjself(vm, c);
+        /* the GC may have run, 'prev' may be scanned or old */
+        be_gc_barrier(vm, prev);
+        prev->super = super;
+        prev = super;
+    }
+    if (obj->class->hasdeinit) { /* only the derived instance is finalized */
+        be_gc_addfinalizer(vm, gc_object(obj));
     }
     be_stackpop(vm, 1);
     return obj;
@@ -111,7 +232,7 @@ int be_class_newobj(bvm *vm, bclass *c, bvalue *argv, int argc)
     binstance *obj = newobject(vm, c);
     var_setinstance(argv, obj);
     /* find constructor */
-    obj = instance_member(obj, be_newstr(vm, "init"), &init);
+    obj = instance_member(obj, vm->opnames[OM_INIT], &init);
     if (obj && var_type(&init) != MT_VARIABLE) {
         /* user constructor */
         bvalue *reg = argv + 1;
@@ -132,17 +253,65 @@ int be_instance_member(binstance *obj, bstring *name, bvalue *dst)
     obj = instance_member(obj, name, dst);
     type = var_type(dst);
     if (obj && type == MT_VARIABLE) {
-        *dst = obj->members[dst->v.i];
+        *dst = obj->members[var_toint(dst)];
     }
     return type;
 }
 
-int be_instance_setmember(binstance *obj, bstring *name, bvalue *src)
+/* be_instance_member() of the operator method 'om', the members found
+ * in the class chain are cached in the class until a class of the chain
+ * is modified, except for the constant classes */
+int be_instance_opmethod(bvm *vm, binstance *obj, int om, bvalue *dst)
+{
+    bclass *c = obj->class;
+    bopcache *cache = c->opcache;
+    uint32_t bit = (uint32_t)1 << om;
+    unsigned int version;
+    if (gc_isconst(c)) {
+        return be_instance_member(obj, vm->opnames[om], dst);
+    }
+    version = be_class_version(c, -1);
+    if (cache == NULL) {
+        cache = be_malloc(vm, sizeof(bopcache));
+        cache->resolved = 0;
+        cache->version = version;
+        c->opcache = cache;
+    } else if (cache->version != version) {
+        cache->resolved = 0;
+        cache->version = version;
+    }
+    if (!(cache->resolved & bit)) {
+        int depth = be_class_member(c, vm->opnames[om], cache->member + om);
+        if (depth < 0) { /* not found, the whole chain is checked */
+            for (depth = 0; c->super; c = c->super) {
+                ++depth;
+            }
+        }
+        cache->depth[om] = (bbyte)depth;
+        cache->resolved |= bit;
+    }
+    *dst = cache->member[om];
+    if (cache->depth[om] || var_isnil(dst)) {
+        binstance *base = be_instance_base(obj, cache->depth[om]);
+        /* the instance has an old chain, see be_instance_base() */
+        if (base == NULL || (var_isnil(dst) && base->super)) {
+            return be_instance_member(obj, vm->opnames[om], dst);
+        }
+        obj = base;
+    }
+    if (var_istype(dst, MT_VARIABLE)) {
+        *dst = obj->members[var_toint(dst)];
+    }
+    return var_type(dst);
+}
+
+int be_instance_setmember(bvm *vm, binstance *obj, bstring *name, bvalue *src)
 {
     bvalue v;
     be_assert(name != NULL);
     obj = instance_member(obj, name, &v);
     if (obj && var_istype(&v, MT_VARIABLE)) {
+        be_gc_barrier(vm, obj);
         obj->members[var_toint(&v)] = *src;
         return 1;
     }
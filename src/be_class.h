@@ -6,41 +6,72 @@
 #define MT_VARIABLE                     BE_INT
 #define MT_METHOD                       BE_CLOSURE
 #define MT_PRIMMETHOD                   BE_NTVFUNC
+#define MT_LPRIMMETHOD                  BE_LNTVFUNC
 
 #define be_class_name(cl)               ((cl)->name)
 #define be_class_members(cl)           ((cl)->members)
 #define be_class_super(cl)              ((cl)->super)
-#define be_class_setsuper(self, sup)    ((self)->super = (sup))
 #define be_instance_name(obj)           ((obj)->class->name)
 #define be_instance_class(obj)           ((obj)->class)
 #define be_instance_members(obj)        ((obj)->members)
 #define be_instance_member_count(obj)   ((obj)->class->nvar)
 #define be_instance_super(obj)          ((obj)->super)
 
+/* the operator and special methods looked up by the virtual machine,
+ * their names are interned once and the lookups are cached per class */
+typedef enum {
+    OM_ADD, OM_SUB, OM_MUL, OM_DIV, OM_MOD,
+    OM_LT, OM_LE, OM_EQ, OM_NE, OM_GT, OM_GE,
+    OM_AND, OM_OR, OM_XOR, OM_SHL, OM_SHR,
+    OM_NEG, OM_FLIP, OM_TOBOOL, OM_ITEM, OM_SETITEM,
+    OM_ITER, OM_HASNEXT, OM_NEXT, OM_INIT, OM_DEINIT,
+    OM_COUNT
+} bopmethod;
+
+/* the cached members of the operator methods of a class */
+typedef struct bopcache {
+    unsigned int version; /* the class chain version when it was filled */
+    uint32_t resolved; /* bit n: member[n] was looked up */
+    bbyte depth[OM_COUNT]; /* the depth of each member, or of the last class */
+    bvalue member[OM_COUNT]; /* the member of the class, nil if none */
+} bopcache;
+
 struct bclass {
     bcommon_header;
     unsigned short nvar; /* members variable count */
+    bbyte hasdeinit; /* the class or a superclass has 'deinit' */
+    unsigned int version; /* the stamp of the last change, see be_class_version() */
     struct bclass *super;
     bmap *members;
     bstring *name;
     bgcobject *gray; /* for gc gray list */
+    bopcache *opcache; /* operator method cache, NULL until used */
 };
 
 struct binstance {
     bcommon_header;
+    unsigned short nvar; /* the size of the members table */
     struct binstance *super;
     bclass *class;
     bgcobject *gray; /* for gc gray list */
     bvalue members[1]; /* members table */
 };
 
+void be_opmethod_init(bvm *vm);
 bclass* be_newclass(bvm *vm, bstring *name, bclass *super);
+void be_class_setsuper(bvm *vm, bclass *c, bclass *super);
+void be_class_free(bvm *vm, bclass *c);
 int be_class_attribute(bclass *c, bstring *attr);
+int be_class_member(bclass *c, bstring *name, bvalue *dst);
 void be_member_bind(bvm *vm, bclass *c, bstring *name);
 void be_method_bind(bvm *vm, bclass *c, bstring *name, bproto *p);
 void be_prim_method_bind(bvm *vm, bclass *c, bstring *name, bntvfunc f);
+void be_prim_lmethod_bind(bvm *vm, bclass *c, bstring *name, blntvfunc f);
 int be_class_newobj(bvm *vm, bclass *c, bvalue *argv, int argc);
+unsigned int be_class_version(bclass *c, int depth);
+binstance* be_instance_base(binstance *obj, int depth);
 int be_instance_member(binstance *obj, bstring *name, bvalue *dst);
-int be_instance_setmember(binstance *obj, bstring *name, bvalue *src);
+int be_instance_opmethod(bvm *vm, binstance *obj, int om, bvalue *dst);
+int be_instance_setmember(bvm *vm, binstance *obj, bstring *name, bvalue *src);
 
 #endif
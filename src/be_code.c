@@ -7,6 +7,7 @@
 #include "be_var.h"
 #include "be_exec.h"
 #include "be_vm.h"
+#include "be_gc.h"
 
 #define NOT_MASK                (1 << 0)
 #define NOT_EXPR                (1 << 1)
@@ -94,6 +95,9 @@ static void setjump(bfuncinfo *finfo, int pc, int dst)
 {
     binstruction *p = be_vector_at(&finfo->code, pc);
     int offset = dst - (pc + 1);
+    if (dst > finfo->lasttarget) {
+        finfo->lasttarget = dst;
+    }
     /* instruction edit jump destination */
     *p = (*p & ~IBx_MASK) | ISET_sBx(offset);
 }
@@ -106,6 +110,10 @@ static int isjumpbool(bfuncinfo *finfo, int pc)
     if (op == OP_JMPT || op == OP_JMPF) {
         return 1;
     }
+    if (op == OP_JMP && pc > 0) { /* the jump of fused relational */
+        op = IGET_OP(p[-1]);
+        return op >= OP_JLT && op <= OP_JGE;
+    }
     return 0;
 }
 
@@ -161,9 +169,31 @@ void be_code_jumpto(bfuncinfo *finfo, int dst)
     be_code_patchlist(finfo, be_code_jump(finfo), dst);
 }
 
+/* if the condition is the result of the last relational instruction,
+ * replace it with the fused compare-and-branch instruction. */
+static int relopjump(bfuncinfo *finfo, bexpdesc *e, int jture)
+{
+    int pc = finfo->pc - 1;
+    if (e->type == ETREG && e->t == NO_JUMP && e->f == NO_JUMP
+            && pc >= 0 && finfo->lasttarget <= pc && finfo->jpc == NO_JUMP) {
+        binstruction *p = be_vector_at(&finfo->code, pc);
+        bopcode op = IGET_OP(*p);
+        if (op >= OP_LT && op <= OP_GE && IGET_RA(*p) == e->v.idx) {
+            op = (bopcode)(op - OP_LT + OP_JLT);
+            *p = (*p & ~(IOP_MASK | IRA_MASK))
+                | ISET_OP(op) | ISET_RA(jture != notmask(e));
+            return appendjump(finfo, OP_JMP, NULL);
+        }
+    }
+    return NO_JUMP;
+}
+
 void be_code_jumpbool(bfuncinfo *finfo, bexpdesc *e, int jture)
 {
-    int pc = appendjump(finfo, jumpboolop(e, jture), e);
+    int pc = relopjump(finfo, e, jture);
+    if (pc == NO_JUMP) {
+        pc = appendjump(finfo, jumpboolop(e, jture), e);
+    }
     be_code_conjump(finfo, jture ? &e->t : &e->f, pc);
     be_code_patchjump(finfo, jture ? e->f : e->t);
     free_expreg(finfo, e);
@@ -171,6 +201,58 @@ void be_code_jumpbool(bfuncinfo *finfo, bexpdesc *e, int jture)
     e->not = 0;
 }
 
+/* if the expression is the range just evaluated by OP_RANGE, replace
+ * it with the FORPREP of the numeric for-loop. The loop variable is
+ * R(var), the counter and limit are R(var+1) and R(var+2). The result
+ * is the jump to exit the loop or NO_JUMP when it cannot be converted. */
+int be_code_forprep(bfuncinfo *finfo, bexpdesc *e, int var)
+{
+    int pc = finfo->pc - 1;
+    if (e->type == ETREG && e->t == NO_JUMP && e->f == NO_JUMP
+            && pc >= 0 && finfo->lasttarget <= pc) {
+        binstruction *p = be_vector_at(&finfo->code, pc);
+        if (IGET_OP(*p) == OP_RANGE && IGET_RA(*p) == e->v.idx) {
+            *p = (*p & ~(IOP_MASK | IRA_MASK))
+                | ISET_OP(OP_FORPREP) | ISET_RA(var);
+            return be_code_jump(finfo);
+        }
+    }
+    return NO_JUMP;
+}
+
+void be_code_forloop(bfuncinfo *finfo, int var, int body)
+{
+    int pc = codeABx(finfo, OP_FORLOOP, var, 0);
+    setjump(finfo, pc, body);
+}
+
+void be_code_iterprep(bfuncinfo *finfo, int obj)
+{
+    codeABC(finfo, OP_ITERPREP, obj, 0, 0);
+}
+
+/* ITERNEXT is followed by the jump to exit the loop, which is skipped
+ * while the iterator has elements. The result is the exit jump. */
+int be_code_iternext(bfuncinfo *finfo, int obj, int var)
+{
+    codeABC(finfo, OP_ITERNEXT, obj, var, 0);
+    return be_code_jump(finfo);
+}
+
+/* append R(list+1)..R(list+n) to the list R(list) */
+void be_code_setlist(bfuncinfo *finfo, int list, int n)
+{
+    codeABC(finfo, OP_SETLIST, list, n, 0);
+    be_code_freeregs(finfo, n);
+}
+
+/* insert the n key-value pairs following R(map) to the map */
+void be_code_setmap(bfuncinfo *finfo, int map, int n)
+{
+    codeABC(finfo, OP_SETMAP, map, n, 0);
+    be_code_freeregs(finfo, n * 2);
+}
+
 /* connect jump */
 void be_code_conjump(bfuncinfo *finfo, int *list, int jmp)
 {
@@ -209,6 +291,7 @@ static int newconst(bfuncinfo *finfo, bvalue *k)
     be_vector_append_c(finfo->lexer->vm, &finfo->kvec, k);
     finfo->proto->ktab = be_vector_data(&finfo->kvec);
     finfo->proto->nconst = be_vector_capacity(&finfo->kvec);
+    be_gc_barrier(finfo->lexer->vm, finfo->proto);
     if (k == NULL) {
         var_setnil(&finfo->proto->ktab[idx]);
     }
@@ -228,17 +311,17 @@ static int findconst(bfuncinfo *finfo, bexpdesc *e)
         bvalue *k = be_vector_at(&finfo->kvec, i);
         switch (e->type) {
         case ETINT:
-            if (var_isint(k) && k->v.i == e->v.i) {
+            if (var_isint(k) && var_toint(k) == e->v.i) {
                 return i;
             }
             break;
         case ETREAL:
-            if (var_isreal(k) && k->v.r == e->v.r) {
+            if (var_isreal(k) && var_toreal(k) == e->v.r) {
                 return i;
             }
             break;
         case ETSTRING:
-            if (var_isstr(k) && be_eqstr(k->v.p, e->v.s)) {
+            if (var_isstr(k) && be_eqstr(var_tostr(k), e->v.s)) {
                 return i;
             }
             break;
@@ -256,16 +339,13 @@ static int exp2const(bfuncinfo *finfo, bexpdesc *e)
         bvalue k;
         switch (e->type) {
         case ETINT:
-            k.type = BE_INT;
-            k.v.i = e->v.i;
+            var_setint(&k, e->v.i);
             break;
         case ETREAL:
-            k.type = BE_REAL;
-            k.v.r = e->v.r;
+            var_setreal(&k, e->v.r);
             break;
         case ETSTRING:
-            k.type = BE_STRING;
-            k.v.s = e->v.s;
+            var_setstr(&k, e->v.s);
             break;
         default:
             break;
@@ -318,7 +398,7 @@ static int var2reg(bfuncinfo *finfo, bexpdesc *e, int dst)
     switch (e->type) {
     case ETINT:
         if (e->v.i >= IsBx_MIN && e->v.i <= IsBx_MAX) {
-            codeABx(finfo, OP_LDINT, dst, var_toidx(e) + IsBx_MAX);
+            codeABx(finfo, OP_LDINT, dst, cast_int(e->v.i) + IsBx_MAX);
         } else {
             return exp2const(finfo, e);
         }
@@ -595,6 +675,19 @@ void be_code_call(bfuncinfo *finfo, int base, int argc)
     be_code_freeregs(finfo, argc);
 }
 
+/* call the builtin function G(idx), the register 'base' was reserved
+ * for the function. calls with one argument use the intrinsic 'fn' */
+void be_code_intrinsic(bfuncinfo *finfo, int base, int argc, int fn, int idx)
+{
+    if (argc == 1) {
+        codeABC(finfo, OP_INTRIN, base, fn, idx);
+    } else {
+        codeABx(finfo, OP_GETGBL, base, idx);
+        codeABC(finfo, OP_CALL, base, argc, 0);
+    }
+    be_code_freeregs(finfo, argc);
+}
+
 int be_code_proto(bfuncinfo *finfo, bproto *proto)
 {
     int idx = be_vector_count(&finfo->pvec);
@@ -602,6 +695,7 @@ int be_code_proto(bfuncinfo *finfo, bproto *proto)
     be_vector_append_c(finfo->lexer->vm, &finfo->pvec, &proto);
     finfo->proto->ptab = be_vector_data(&finfo->pvec);
     finfo->proto->nproto = be_vector_capacity(&finfo->pvec);
+    be_gc_barrier(finfo->lexer->vm, finfo->proto);
     return idx;
 }
 
@@ -631,12 +725,27 @@ void be_code_close(bfuncinfo *finfo, int isret)
     }
 }
 
+/* set the C operand of the call in 'return f(...)' to mark it as a
+ * tail call, which reuses the call frame if f is a closure */
+static void code_tailcall(bfuncinfo *finfo, bexpdesc *e)
+{
+    int pc = finfo->pc - 1;
+    if (e->type == ETREG && e->t == NO_JUMP && e->f == NO_JUMP && pc >= 0) {
+        binstruction *p = be_vector_at(&finfo->code, pc);
+        if (IGET_OP(*p) == OP_CALL && IGET_RA(*p) == e->v.idx) {
+            *p |= ISET_RKC(1);
+        }
+    }
+}
+
 void be_code_ret(bfuncinfo *finfo, bexpdesc *e)
 {
     if (e == NULL) {
         codeABC(finfo, OP_RET, 0, 0, 0);
     } else {
-        int reg = exp2anyreg(finfo, e);
+        int reg;
+        code_tailcall(finfo, e);
+        reg = exp2anyreg(finfo, e);
         be_code_close(finfo, 1);
         codeABC(finfo, OP_RET, e->type != ETVOID, reg, 0);
         free_expreg(finfo, e);
@@ -16,11 +16,18 @@ int be_code_nextreg(bfuncinfo *finfo, bexpdesc *e);
 int be_code_jump(bfuncinfo *finfo);
 void be_code_jumpto(bfuncinfo *finfo, int dst);
 void be_code_jumpbool(bfuncinfo *finfo, bexpdesc *e, int jumptrue);
+int be_code_forprep(bfuncinfo *finfo, bexpdesc *e, int var);
+void be_code_forloop(bfuncinfo *finfo, int var, int body);
+void be_code_iterprep(bfuncinfo *finfo, int obj);
+int be_code_iternext(bfuncinfo *finfo, int obj, int var);
+void be_code_setlist(bfuncinfo *finfo, int list, int n);
+void be_code_setmap(bfuncinfo *finfo, int map, int n);
 void be_code_conjump(bfuncinfo *finfo, int *list, int jmp);
 void be_code_patchlist(bfuncinfo *finfo, int list, int dst);
 void be_code_patchjump(bfuncinfo *finfo, int jmp);
 int be_code_getmethod(bfuncinfo *finfo, bexpdesc *e);
 void be_code_call(bfuncinfo *finfo, int base, int argc);
+void be_code_intrinsic(bfuncinfo *finfo, int base, int argc, int fn, int idx);
 int be_code_proto(bfuncinfo *finfo, bproto *proto);
 void be_code_closure(bfuncinfo *finfo, bexpdesc *e, int idx);
 void be_code_close(bfuncinfo *finfo, int isret);
@@ -9,7 +9,6 @@
 #include "be_module.h"
 
 #define be_const_header(_t)  \
-    .next = NULL,            \
     .type = (_t),            \
     .marked = GC_CONST
 
@@ -17,6 +16,46 @@
 #define be_const_header_class()     be_const_header(BE_CLASS)
 #define be_const_header_module()    be_const_header(BE_MODULE)
 
+#if BE_USE_NAN_BOXING
+/* the tag of a constant object is added to its address */
+#define be_const_nanobj(_t, _o)     ((char *)&(_o) + nanbox_bits(_t))
+
+#define be_const_key(_str, _next)   \
+{ \
+    .v.p = be_const_nanobj(BE_STRING, _str), \
+    .next = (uint32_t)(_next) & 0xFFFFFF \
+}
+
+#define be_const_func(_func) \
+{ \
+    .v.nf = (_func) \
+}
+
+#define be_const_lfunc(_func) \
+{ \
+    .v.u = nanbox_bits(BE_LNTVFUNC) + (uintptr_t)(_func) \
+}
+
+#define be_const_int(_val) \
+{ \
+    .v.u = nanbox_bits(BE_INT) | (uint32_t)(_val) \
+}
+
+#define be_const_real(_val) \
+{ \
+    .v.r = (_val) \
+}
+
+#define be_const_class(_class) \
+{ \
+    .v.p = be_const_nanobj(BE_CLASS, _class) \
+}
+
+#define be_const_module(_module) \
+{ \
+    .v.p = be_const_nanobj(BE_MODULE, _module) \
+}
+#else
 #define be_const_key(_str, _next)   \
 { \
     .v.s = (bstring *)&(_str), \
@@ -30,6 +69,12 @@
     .type = BE_FUNCTION \
 }
 
+#define be_const_lfunc(_func) \
+{ \
+    .v.lf = (_func), \
+    .type = BE_LNTVFUNC \
+}
+
 #define be_const_int(_val) \
 { \
     .v.i = (_val), \
@@ -53,6 +98,7 @@
     .v.p = (bmodule *)&(_module), \
     .type = BE_MODULE \
 }
+#endif
 
 #define be_define_const_module(_module)             \
 bntvmodule be_native_module(_module) = {            \
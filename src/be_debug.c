@@ -4,7 +4,6 @@
 #include "be_string.h"
 #include "be_class.h"
 #include "be_vm.h"
-#include "be_vector.h"
 #include "be_strlib.h"
 #include "be_exec.h"
 #include <stdio.h>
@@ -38,18 +37,27 @@ static void print_inst(binstruction ins, int pc)
     case OP_GETMBR: case OP_SETMBR:  case OP_GETMET:
     case OP_GETIDX: case OP_SETIDX: case OP_AND:
     case OP_OR: case OP_XOR: case OP_SHL: case OP_SHR:
+    case OP_JLT: case OP_JLE: case OP_JEQ: case OP_JNE:
+    case OP_JGT: case OP_JGE: case OP_ADDINT: case OP_ADDREAL:
+    case OP_SUBINT: case OP_SUBREAL: case OP_MULINT: case OP_MULREAL:
+    case OP_DIVINT: case OP_DIVREAL: case OP_FORPREP:
         logbuf("%s\tR%d\tR%d\tR%d", be_opcode2str(op), IGET_RA(ins), IGET_RKB(ins), IGET_RKC(ins));
         break;
+    case OP_JCMPINT:
+        logbuf("%s\t%s %d\tR%d\tR%d", be_opcode2str(op), be_opcode2str(IJCMP_OP(ins)),
+            IJCMP_RA(ins), IGET_RKB(ins), IGET_RKC(ins));
+        break;
     case OP_GETGBL: case OP_SETGBL:
         logbuf("%s\tR%d\tG:%d", be_opcode2str(op), IGET_RA(ins), IGET_Bx(ins));
         break;
     case OP_MOVE: case OP_SETSUPER: case OP_NEG: case OP_FLIP: case OP_IMPORT:
+    case OP_ITERNEXT:
         logbuf("%s\tR%d\tR%d", be_opcode2str(op), IGET_RA(ins), IGET_RKB(ins));
         break;
     case OP_JMP:
         logbuf("%s\t\t[%d]", be_opcode2str(op), IGET_sBx(ins) + pc + 1);
         break;
-    case OP_JMPT: case OP_JMPF:
+    case OP_JMPT: case OP_JMPF: case OP_FORLOOP:
         logbuf("%s\tR%d\t[%d]", be_opcode2str(op), IGET_RA(ins), IGET_sBx(ins) + pc + 1);
         break;
     case OP_LDINT:
@@ -64,15 +72,21 @@ static void print_inst(binstruction ins, int pc)
     case OP_GETUPV: case OP_SETUPV:
         logbuf("%s\tR%d\tU:%d", be_opcode2str(op), IGET_RA(ins), IGET_Bx(ins));
         break;
-    case OP_CALL:
+    case OP_CALL: case OP_SETLIST: case OP_SETMAP:
         logbuf("%s\tR%d\t%d", be_opcode2str(op), IGET_RA(ins), IGET_RKB(ins));
         break;
+    case OP_INTRIN:
+        logbuf("%s\tR%d\t%d\tG:%d", be_opcode2str(op), IGET_RA(ins), IGET_RKB(ins), IGET_RKC(ins));
+        break;
     case OP_CLOSURE:
         logbuf("%s\tR%d\tP:%d", be_opcode2str(op), IGET_RA(ins), IGET_Bx(ins));
         break;
     case OP_CLOSE:
         logbuf("%s\t%d", be_opcode2str(op), IGET_RA(ins));
         break;
+    case OP_ITERPREP:
+        logbuf("%s\tR%d", be_opcode2str(op), IGET_RA(ins));
+        break;
     default:
         logbuf("%s", be_opcode2str(op));
         break;
@@ -108,8 +122,8 @@ void be_dumpclosure(bclosure *cl)
 static const char* sourceinfo(bvm *vm, char *buf, int deepth)
 {
 #if BE_DEBUG_RUNTIME_INFO
-    int size = be_stack_count(&vm->callstack);
-    bcallframe *cf = be_vector_at(&vm->callstack, size + deepth);
+    int size = vm->calldepth;
+    bcallframe *cf = be_callframe(vm, size + deepth);
     bproto *proto = cast(bclosure*, var_toobj(cf->func))->proto;
     blineinfo *start = proto->lineinfo;
     blineinfo *it = start + proto->nlineinfo - 1;
@@ -117,7 +131,7 @@ static const char* sourceinfo(bvm *vm, char *buf, int deepth)
     if (deepth == -1) {
         pc = cast_int(vm->ip - proto->code);
     } else {
-        cf = be_vector_at(&vm->callstack, size + deepth + 1);
+        cf = be_callframe(vm, size + deepth + 1);
         pc = cast_int(cf->ip - proto->code);
     }
     while (it > start && it->endpc > pc) {
@@ -150,8 +164,8 @@ void be_debug_ins_info(bvm *vm)
 
 static void patch_native(bvm *vm, int deepth)
 {
-    int size = be_stack_count(&vm->callstack);
-    bcallframe *cf = be_vector_at(&vm->callstack, size + deepth);
+    int size = vm->calldepth;
+    bcallframe *cf = be_callframe(vm, size + deepth);
     if (deepth == -1) {
         cf->ip = vm->ip;
     } else {
@@ -161,9 +175,9 @@ static void patch_native(bvm *vm, int deepth)
 
 static void tracestack(bvm *vm)
 {
-    int deepth, size = be_stack_count(&vm->callstack);
+    int deepth, size = vm->calldepth;
     for (deepth = 1; deepth <= size; ++deepth) {
-        bcallframe *cf = be_vector_at(&vm->callstack, size - deepth);
+        bcallframe *cf = be_callframe(vm, size - deepth);
         if (var_isclosure(cf->func)) {
             char buf[100];
             bclosure *cl = var_toobj(cf->func);
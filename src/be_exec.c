@@ -1,7 +1,7 @@
 #include "be_exec.h"
 #include "be_parser.h"
 #include "be_vm.h"
-#include "be_vector.h"
+#include "be_func.h"
 #include "be_mem.h"
 #include "be_sys.h"
 #include "be_debug.h"
@@ -13,10 +13,7 @@
 #define exec_try(j)         if (setjmp((j)->b) == 0)
 #define exec_throw(j)       longjmp((j)->b, 1)
 
-#define STR(s)              #s
-
-#define STACK_OVER_MSG(n) \
-    "stack overflow (maximum stack size is " STR(n) ")"
+#define STACK_OVER_MSG    "stack overflow (maximum stack size is %d)"
 
 #ifdef BE_EXPLICIT_ABORT
   #define abort             BE_EXPLICIT_ABORT
@@ -171,20 +168,23 @@ int be_protectedcall(bvm *vm, bvalue *v, int argc)
 {
     int res;
     struct pcall s;
-    int calldepth = be_stack_count(&vm->callstack);
+    int calldepth = vm->calldepth;
     int reg = cast_int(vm->reg - vm->stack);
     int top = cast_int(vm->top - vm->stack);
+    int func = cast_int(v - vm->stack);
     s.v = v;
     s.argc = argc;
     res = be_execprotected(vm, m_pcall, &s);
     if (res) { /* recovery call stack */
         int idx = cast_int(vm->top - (vm->stack + reg));
+        /* close the upvalues of the aborted functions */
+        be_upvals_close(vm, vm->stack + func);
         vm->reg = vm->stack + reg;
         be_moveto(vm, idx, top - reg + 1); /* copy error information */
         vm->top = vm->stack + top + 1;
-        be_assert(be_stack_count(&vm->callstack) >= calldepth);
-        be_vector_resize(vm, &vm->callstack, calldepth);
-        vm->cf = be_stack_top(&vm->callstack);
+        be_assert(vm->calldepth >= calldepth);
+        vm->calldepth = calldepth;
+        vm->cf = calldepth ? be_callframe(vm, calldepth - 1) : NULL;
     }
     return res;
 }
@@ -213,37 +213,105 @@ void be_stack_require(bvm *vm, int count)
     }
 }
 
+void be_setbudget(bvm *vm, int count, bbudgethook hook)
+{
+    vm->budget = count > 0 ? count : 0;
+    vm->budgethook = hook;
+}
+
 static void update_callstack(bvm *vm, bvalue *oldstack)
 {
-    bcallframe *cf = be_stack_top(&vm->callstack);
-    bcallframe *base = be_stack_base(&vm->callstack);
+    bcallframe *cf = vm->callstack;
+    bcallframe *end = cf + vm->calldepth;
     bvalue *stack = vm->stack;
-    for (; cf >= base; --cf) {
+    bupval **tab = vm->upvaltab;
+    int i;
+    for (; cf < end; ++cf) {
         cf->func = stack + (cf->func - oldstack);
         cf->top = stack + (cf->top - oldstack);
         cf->reg = stack + (cf->reg - oldstack);
     }
+    for (i = 0; i < vm->upvaltop; ++i) { /* the open upvalues */
+        if (tab[i]) {
+            tab[i]->value = stack + i;
+        }
+    }
     vm->top = stack + (vm->top - oldstack);
     vm->reg = stack + (vm->reg - oldstack);
 }
 
 static void stack_resize(bvm *vm, size_t size)
 {
-    bvalue *old = vm->stack;
-    size_t os = (vm->stacktop - old) * sizeof(bvalue);
-    vm->stack = be_realloc(vm, old, os, sizeof(bvalue) * size);
+    bvalue *old = vm->stack, *v;
+    size_t i, osize = vm->stacktop - old;
+    vm->stack = be_realloc(vm, old,
+        osize * sizeof(bvalue), size * sizeof(bvalue));
+    vm->upvaltab = be_realloc(vm, vm->upvaltab,
+        osize * sizeof(bupval*), size * sizeof(bupval*));
+    v = vm->stack + osize;
     vm->stacktop = vm->stack + size;
+    /* the new slots may be scanned by the GC before they are written */
+    while (v < vm->stacktop) {
+        var_setnil(v++);
+    }
+    for (i = osize; i < size; ++i) {
+        vm->upvaltab[i] = NULL;
+    }
     update_callstack(vm, old);
 }
 
 void be_stack_expansion(bvm *vm, int n)
 {
     size_t size = vm->stacktop - vm->stack;
+    size_t need = size + n, limit = (size_t)vm->stacklimit;
     /* check new stack size */
-    if (size + n > BE_STACK_TOTAL_MAX) {
+    if (need > limit) {
         /* ensure the stack is enough when generating error messages. */
         stack_resize(vm, size + 1);
-        be_pusherror(vm, STACK_OVER_MSG(BE_STACK_TOTAL_MAX));
+        be_pusherror(vm, be_pushfstring(vm, STACK_OVER_MSG, vm->stacklimit));
+    }
+    /* grow geometrically to amortize the reallocations of deep calls */
+    size = size * 2 > need ? size * 2 : need;
+    stack_resize(vm, size < limit ? size : limit);
+}
+
+/* the stack slots used by the running frames */
+static size_t stack_used(bvm *vm)
+{
+    bvalue *top = vm->top;
+    bcallframe *cf = vm->callstack;
+    bcallframe *end = cf + vm->calldepth;
+    for (; cf < end; ++cf) { /* the caller frames may use more */
+        top = cf->top > top ? cf->top : top;
+    }
+    return top - vm->stack + BE_STACK_FREE_MIN;
+}
+
+/* the stack may already be larger than a new limit, it is then shrunk
+ * as far as the running frames allow. */
+void be_setstacklimit(bvm *vm, int size)
+{
+    size_t used, limit;
+    vm->stacklimit = size > BE_STACK_FREE_MIN * 2 ? size : BE_STACK_FREE_MIN * 2;
+    limit = (size_t)vm->stacklimit;
+    if ((size_t)(vm->stacktop - vm->stack) > limit && !be_inlightcall(vm)) {
+        used = stack_used(vm);
+        stack_resize(vm, used > limit ? used : limit);
+    }
+}
+
+/* release the stack space left by a deep recursion, the stack is only
+ * shrunk when less than a quarter of it is used. */
+void be_stack_shrink(bvm *vm)
+{
+    size_t used, size = vm->stacktop - vm->stack;
+    if (be_inlightcall(vm)) { /* the caller's registers are above the top */
+        return;
+    }
+    if (size > BE_STACK_FREE_MIN * 16 && (size_t)(vm->top - vm->stack) < size / 4) {
+        used = stack_used(vm);
+        if (used < size / 4) {
+            stack_resize(vm, used * 2);
+        }
     }
-    stack_resize(vm, size + n);
 }
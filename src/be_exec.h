@@ -21,5 +21,6 @@ int be_protectedparser(bvm *vm,
 int be_protectedcall(bvm *vm, bvalue *v, int argc);
 void be_stackpush(bvm *vm);
 void be_stack_expansion(bvm *vm, int n);
+void be_stack_shrink(bvm *vm);
 
 #endif
@@ -130,17 +130,17 @@ int be_nfunc_open(bvm *vm)
     int argc = be_top(vm);
     const char *fname, *mode;
     static const bnfuncinfo members[] = {
-        { ".data", NULL },
-        { "write", i_write },
-        { "read", i_read },
-        { "readline", i_readline },
-        { "seek", i_seek },
-        { "tell", i_tell },
-        { "size", i_size },
-        { "flush", i_flush },
-        { "close", i_close },
-        { "deinit", i_close },
-        { NULL, NULL }
+        { ".data", NULL, NULL },
+        { "write", i_write, NULL },
+        { "read", i_read, NULL },
+        { "readline", i_readline, NULL },
+        { "seek", i_seek, NULL },
+        { "tell", i_tell, NULL },
+        { "size", i_size, NULL },
+        { "flush", i_flush, NULL },
+        { "close", i_close, NULL },
+        { "deinit", i_close, NULL },
+        { NULL, NULL, NULL }
     };
     fname = argc >= 1 && be_isstring(vm, 1) ? be_tostring(vm, 1) : NULL;
     mode = argc >= 2 && be_isstring(vm, 2) ? be_tostring(vm, 2) : "r";
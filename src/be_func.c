@@ -14,50 +14,56 @@ void be_initupvals(bvm *vm, bclosure *cl)
     bvalue *stack = vm->reg;
     bupval **superuv = curcl(vm)->upvals;
     for (i = 0; i < count; ++i) {
-        bvalue *ref;
+        bupval *uv;
         if (desc->instack) {
-            ref = stack + desc->idx;
-        } else {
-            ref = superuv[desc->idx]->value;
+            uv = be_findupval(vm, stack + desc->idx);
+        } else { /* share the upvalue of the enclosing function */
+            uv = superuv[desc->idx];
         }
         desc++;
-        cl->upvals[i] = be_findupval(vm, ref);
-        cl->upvals[i]->refcnt++;
+        uv->refcnt++;
+        cl->upvals[i] = uv;
     }
 }
 
+/* get the open upvalue of the stack slot 'level', the upvalues are
+ * indexed by the stack slots so the lookup does not search */
 bupval* be_findupval(bvm *vm, bvalue *level)
 {
-    bupval *node = vm->upvalist;
-    while (node != NULL && node->value > level) {
-        node = node->u.next;
-    }
-    if (!node || node->value != level) {
-        /* not found */
+    int idx = cast_int(level - vm->stack);
+    bupval *node = vm->upvaltab[idx];
+    if (!node) { /* not found */
         node = be_malloc(vm, sizeof(bupval));
         node->value = level;
         node->refcnt = 0;
-        /* insert to list head */
-        node->u.next = vm->upvalist;
-        vm->upvalist = node;
+        vm->upvaltab[idx] = node;
+        if (idx >= vm->upvaltop) {
+            vm->upvaltop = idx + 1;
+        }
     }
     return node;
 }
 
+/* close the open upvalues at or above the stack slot 'level'. only the
+ * slots below vm->upvaltop are visited, which are the registers of the
+ * current function when it is called by OP_CLOSE. */
 void be_upvals_close(bvm *vm, bvalue *level)
 {
-    bupval *node = vm->upvalist, *next;
-    while (node && node->value >= level) {
-        next = node->u.next;
-        if (!node->refcnt) {
-            be_free(vm, node, sizeof(bupval));
-        } else {
-            node->u.value = *node->value; /* move value to upvalue slot */
-            node->value = &node->u.value;
+    int idx = cast_int(level - vm->stack);
+    bupval **tab = vm->upvaltab;
+    for (; vm->upvaltop > idx; --vm->upvaltop) {
+        bupval *node = tab[vm->upvaltop - 1];
+        if (node) {
+            tab[vm->upvaltop - 1] = NULL;
+            if (!node->refcnt) {
+                be_free(vm, node, sizeof(bupval));
+            } else {
+                node->closed = *node->value; /* move value to upvalue slot */
+                node->value = &node->closed;
+                be_gc_barrierval(vm, node->value);
+            }
         }
-        node = next;
     }
-    vm->upvalist = node;
 }
 
 bproto* be_newproto(bvm *vm)
@@ -70,6 +76,8 @@ bproto* be_newproto(bvm *vm)
         p->ktab = NULL;
         p->ptab = NULL;
         p->code = NULL;
+        p->mcache = NULL;
+        p->closure = NULL;
         p->name = NULL;
         p->codesize = 0;
         p->nlocal = 0;
@@ -79,6 +87,10 @@ bproto* be_newproto(bvm *vm)
         p->nstack = 0;
         p->codesize = 0;
         p->argc = 0;
+#if BE_USE_JIT
+        p->jit = NULL;
+        p->hotness = 0;
+#endif
 #if BE_DEBUG_RUNTIME_INFO
         p->source = NULL;
         p->lineinfo = NULL;
@@ -108,7 +120,7 @@ static void init_upvals(bvm *vm, bntvclos *f)
     bupval **upvals = &be_ntvclos_upval(f, 0);
     while (count--) {
         bupval *uv = be_malloc(vm, sizeof(bupval)); /* was closed */
-        uv->value = &uv->u.value;
+        uv->value = &uv->closed;
         uv->refcnt = 1;
         var_setnil(uv->value);
         *upvals++ = uv;
@@ -11,46 +11,123 @@
 #include "be_module.h"
 #include "be_exec.h"
 #include "be_debug.h"
+#include "be_jit.h"
+#include <string.h>
 
 #define GC_PAUSE    (1 << 0) /* GC will not be executed automatically */
 #define GC_HALT     (1 << 1) /* GC completely stopped */
 #define GC_ALLOC    (1 << 2) /* GC in alloc */
+#define GC_MAJOR    (1 << 3) /* the next generational collection is major */
+#define GC_YOUNG    (1 << 4) /* a young object was found by the marking */
+
+#if BE_GC_PROMOTE_AGE < 1 || BE_GC_PROMOTE_AGE > 7
+  #error "BE_GC_PROMOTE_AGE must be in the range 1 to 7."
+#endif
+
+/* a minor collection is run when the memory usage has grown by this
+ * percentage of the usage after the last major collection */
+#define GC_MINOR_RATE       20
 
 #define gc_try(expr)        be_assert(expr);
 #define next_threshold(gc)  ((gc).usage * ((gc).steprate + 100) / 100)
 
-#define link_gray(vm, obj)     { \
-    (obj)->gray = (vm)->gc.gray; \
-    (vm)->gc.gray = gc_object(obj);       \
-}
+/* without the memory pool, the short strings are swept with the string
+ * table, the other objects are swept with the GC pages or the object set */
+#define gc_instrtab(o) (!BE_USE_MEM_POOL && \
+    (o)->type == BE_STRING && cast(bstring*, o)->slen != 255)
+
+/* the object of the bit 'i' in a GC page */
+#define page_object(p, i) \
+    cast(bgcobject*, cast(char*, p) + (size_t)(i) * MEM_POOL_ALIGN)
 
-static void destruct_object(bvm *vm, bgcobject *obj);
 static void free_object(bvm *vm, bgcobject *obj);
 
+#if BE_USE_MEM_POOL
+/* the index of the lowest set bit of a word */
+static int lowbit(uint32_t word)
+{
+    static const bbyte table[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+    return table[(uint32_t)((word & (~word + 1)) * 0x077CB531u) >> 27];
+}
+#endif
+
 void be_gc_init(bvm *vm)
 {
-    vm->gc.list = NULL;
     vm->gc.gray = NULL;
-    vm->gc.fixed = NULL;
+    vm->gc.grayagain = NULL;
+    vm->gc.sweep = 0;
+    vm->gc.sweeppage = NULL;
+    vm->gc.sweepid = 0;
     vm->gc.usage = sizeof(bvm);
+    vm->gc.majorbase = 0;
     vm->gc.status = 0;
+    vm->gc.state = GC_SPAUSE;
+    vm->gc.white = GC_WHITE;
     be_gc_setsteprate(vm, 200);
+    be_gc_setstepsize(vm, BE_GC_STEP_SIZE);
+    be_stack_init(vm, &vm->gc.objects, sizeof(bgcobject*));
+    be_stack_init(vm, &vm->gc.old, sizeof(bgcobject*));
+    be_stack_init(vm, &vm->gc.fixed, sizeof(bgcobject*));
+    be_stack_init(vm, &vm->gc.remember, sizeof(bgcobject*));
+    be_stack_init(vm, &vm->gc.youngstr, sizeof(bgcobject*));
+    be_stack_init(vm, &vm->gc.youngpages, sizeof(bgcpage*));
+    be_stack_init(vm, &vm->gc.finobj, sizeof(bgcobject*));
+    be_stack_init(vm, &vm->gc.tobefnz, sizeof(bgcobject*));
+    be_gc_setgenerational(vm, BE_GC_GENERATIONAL);
+}
+
+/* free all objects of an object set */
+static void free_set(bvm *vm, bstack *set)
+{
+    bgcobject **p = be_stack_base(set);
+    bgcobject **end = p + be_stack_count(set);
+    for (; p < end; ++p) {
+        free_object(vm, *p);
+    }
+    be_stack_clear(set);
 }
 
 void be_gc_deleteall(bvm *vm)
 {
-    bgcobject *node, *next;
+    bgcobject **p, **end;
+    /* first: call the finalizers of all objects */
+    p = be_stack_base(&vm->gc.finobj);
+    end = p + be_stack_count(&vm->gc.finobj);
+    for (; p < end; ++p) {
+        be_stack_push(vm, &vm->gc.tobefnz, p);
+    }
+    be_stack_clear(&vm->gc.finobj);
+    be_gc_finalize(vm);
     /* halt GC and delete all objects */
     vm->gc.status |= GC_HALT;
-    /* first: call destructor */
-    for (node = vm->gc.list; node; node = node->next) {
-        destruct_object(vm, node);
-    }
     /* second: free objects */
-    for (node = vm->gc.list; node; node = next) {
-        next = node->next;
-        free_object(vm, node);
+    free_set(vm, &vm->gc.objects);
+    free_set(vm, &vm->gc.old);
+#if BE_USE_MEM_POOL
+    { /* the empty pages are freed with the pool */
+        bgcpage *page = vm->pool.gcpages;
+        for (; page; page = page->next) {
+            int i;
+            for (i = 0; i < MEM_PAGE_WORDS; ++i) {
+                uint32_t alloc = page->alloc[i];
+                for (; alloc; alloc &= alloc - 1) {
+                    free_object(vm, page_object(page, i * 32 + lowbit(alloc)));
+                }
+            }
+        }
     }
+#endif
+    be_stack_delete(vm, &vm->gc.objects);
+    be_stack_delete(vm, &vm->gc.old);
+    be_stack_delete(vm, &vm->gc.fixed);
+    be_stack_delete(vm, &vm->gc.remember);
+    be_stack_delete(vm, &vm->gc.youngstr);
+    be_stack_delete(vm, &vm->gc.youngpages);
+    be_stack_delete(vm, &vm->gc.finobj);
+    be_stack_delete(vm, &vm->gc.tobefnz);
     /* vm->gc will be used afterwards, so it is not free here. */
 }
 
@@ -70,61 +147,183 @@ void be_gc_setpause(bvm *vm, int pause)
     }
 }
 
+void be_gc_setstepsize(bvm *vm, int size)
+{
+    vm->gc.stepsize = size > 0 ? size : 0;
+}
+
+/* the small objects are allocated in the GC pages, where the sweep finds
+ * them at once, so the collection runs before the allocation */
 bgcobject* be_newgcobj(bvm *vm, int type, size_t size)
 {
-    bgcobject *obj = be_malloc(vm, size);
+    bgcobject *obj;
     be_gc_auto(vm);
-    var_settype(obj, (bbyte)type); /* mark the object type */
-    obj->marked = GC_WHITE; /* default gc object type is white */
-    obj->next = vm->gc.list; /* link to the next field */
-    vm->gc.list = obj; /* insert to head */
+    obj = be_mempool_gcalloc(vm, size);
+    if (obj) {
+        obj->type = (bbyte)type;
+        obj->marked = GC_PAGED;
+        gc_setwhite(vm, obj);
+        if (vm->gc.state == GC_SGENERATIONAL && !gc_page(obj)->young) {
+            bgcpage *page = gc_page(obj); /* a new young page */
+            be_stack_push(vm, &vm->gc.youngpages, &page);
+            page->young = 1;
+        }
+        return obj;
+    }
+    obj = be_malloc(vm, size);
+    be_stack_push(vm, &vm->gc.objects, &obj); /* add to the object set */
+    obj->type = (bbyte)type; /* mark the object type */
+    obj->marked = vm->gc.white; /* default gc object type is white */
     return obj;
 }
 
+/* the short strings are in the GC pages, or only in the string table
+ * when the memory pool is not used */
 bgcobject* be_gc_newstr(bvm *vm, size_t size, int islong)
 {
     bgcobject *obj;
-    if (islong) { /* creating long strings is similar to ordinary GC objects */
+    if (islong || BE_USE_MEM_POOL) { /* as the ordinary GC objects */
         return be_newgcobj(vm, BE_STRING, size);
     }
     obj = be_malloc(vm, size);
     be_gc_auto(vm);
-    var_settype(obj, BE_STRING); /* mark the object type to BE_STRING */
-    obj->marked = GC_WHITE; /* default string type is white */
+    obj->type = BE_STRING; /* mark the object type to BE_STRING */
+    obj->marked = vm->gc.white; /* default string type is white */
+    if (vm->gc.state == GC_SGENERATIONAL) {
+        /* the minor collections sweep the young strings only */
+        be_stack_push(vm, &vm->gc.youngstr, &obj);
+    }
     return obj;
 }
 
-void be_gc_fix(bvm *vm, bgcobject *obj)
+/* get the link field of the gray list in the object, the objects
+ * without references (e.g. strings) are never in the gray list */
+static bgcobject** gray_link(bgcobject *obj)
 {
-    (void)vm;
-    if (!gc_isconst(obj)) {
-        gc_setfixed(obj);
+    switch (obj->type) {
+    case BE_CLASS: return &cast_class(obj)->gray;
+    case BE_PROTO: return &cast_proto(obj)->gray;
+    case BE_INSTANCE: return &cast_instance(obj)->gray;
+    case BE_MAP: return &cast_map(obj)->gray;
+    case BE_LIST: return &cast_list(obj)->gray;
+    case BE_CLOSURE: return &cast_closure(obj)->gray;
+    case BE_NTVCLOS: return &cast_ntvclos(obj)->gray;
+    case BE_MODULE: return &cast_module(obj)->gray;
+    default: return NULL;
     }
 }
 
-void be_gc_unfix(bvm *vm, bgcobject *obj)
+static void mark_gray(bvm *vm, bgcobject *obj)
 {
-    (void)vm;
-    if (!gc_isconst(obj)) {
-        gc_clearfixed(obj);
+    if (obj && !(obj->marked & (GC_FIXED | GC_CONST)) && !gc_isold(obj)) {
+        vm->gc.status |= GC_YOUNG; /* see mark_remembered() */
+    }
+    if (obj && gc_iswhite(obj) && !gc_isconst(obj)) {
+        bgcobject **link = gray_link(obj);
+        if (link) {
+            gc_setgray(obj);
+            *link = vm->gc.gray;
+            vm->gc.gray = obj;
+        } else {
+            gc_setdark(obj); /* just set dark */
+        }
     }
 }
 
-static void mark_gray(bvm *vm, bgcobject *obj)
+/* add an old object to the remembered set, it is scanned by the minor
+ * collections until it has no young object. the remembered objects
+ * are gray, so the write barriers are not triggered by them */
+static void remember(bvm *vm, bgcobject *obj)
 {
-    if (obj && gc_iswhite(obj) && !gc_isconst(obj)) {
+    if (gray_link(obj)) {
         gc_setgray(obj);
-        switch (var_type(obj)) {
-        case BE_STRING: gc_setdark(obj); break; /* just set dark */
-        case BE_CLASS: link_gray(vm, cast_class(obj)); break;
-        case BE_PROTO: link_gray(vm, cast_proto(obj)); break;
-        case BE_INSTANCE: link_gray(vm, cast_instance(obj)); break;
-        case BE_MAP: link_gray(vm, cast_map(obj)); break;
-        case BE_LIST: link_gray(vm, cast_list(obj)); break;
-        case BE_CLOSURE: link_gray(vm, cast_closure(obj)); break;
-        case BE_NTVCLOS: link_gray(vm, cast_ntvclos(obj)); break;
-        case BE_MODULE: link_gray(vm, cast_module(obj)); break;
-        default: break;
+        be_stack_push(vm, &vm->gc.remember, &obj);
+    } else {
+        gc_setdark(obj);
+    }
+}
+
+static void promote(bvm *vm, bgcobject *obj)
+{
+    gc_setold(obj);
+    remember(vm, obj); /* it may refer to young objects */
+}
+
+void be_gc_markval(bvm *vm, bvalue *v)
+{
+    bgcobject *obj = var_togc(v);
+    if (vm->gc.state == GC_SPROPAGATE) {
+        mark_gray(vm, obj);
+    } else if (!gc_isold(obj) && !gc_isconst(obj) && !gc_isfixed(obj)) {
+        /* the object cannot be found from the old objects, so it is
+         * promoted at once, see survive() */
+        promote(vm, obj);
+    }
+}
+
+void be_gc_barrierback(bvm *vm, bgcobject *obj)
+{
+    if (vm->gc.state == GC_SPROPAGATE) {
+        bgcobject **link = gray_link(obj);
+        be_assert(link != NULL);
+        gc_setgray(obj);
+        *link = vm->gc.grayagain;
+        vm->gc.grayagain = obj;
+    } else if (gc_isold(obj)) {
+        remember(vm, obj);
+    }
+}
+
+/* remove an object from the set of the GC objects */
+static void set_remove(bstack *set, bgcobject *obj)
+{
+    bgcobject **p = be_stack_base(set);
+    bgcobject **end = p + be_stack_count(set);
+    while (p < end && *p != obj) {
+        ++p;
+    }
+    if (p < end) {
+        *p = *(end - 1);
+        be_stack_pop(set);
+    }
+}
+
+/* a fixed object stays in its page or the object set and it stays
+ * young in the generational mode, the set of the fixed objects is used
+ * to mark them as roots. so fixing an object does not search the objects */
+void be_gc_fix(bvm *vm, bgcobject *obj)
+{
+    if (!gc_isconst(obj) && !gc_isfixed(obj)) {
+        gc_setfixed(obj);
+        if (!gc_instrtab(obj)) {
+            be_stack_push(vm, &vm->gc.fixed, &obj);
+            if (gc_isold(obj)) { /* the fixed objects are roots */
+                set_remove(&vm->gc.remember, obj);
+                gc_clearold(obj);
+            }
+            gc_setage(obj, 0);
+        }
+        if (vm->gc.state == GC_SPROPAGATE) {
+            mark_gray(vm, obj); /* the fixed objects are marked as roots */
+        } else if (!gc_instrtab(obj)) {
+            gc_setwhite(vm, obj);
+        }
+    }
+}
+
+void be_gc_unfix(bvm *vm, bgcobject *obj)
+{
+    if (!gc_isconst(obj) && gc_isfixed(obj)) {
+        gc_clearfixed(obj);
+        if (!gc_instrtab(obj)) {
+            set_remove(&vm->gc.fixed, obj);
+            if (vm->gc.state == GC_SGENERATIONAL) {
+                /* it may be referred by the old objects, which the
+                 * minor collections do not mark */
+                promote(vm, obj);
+            } else if (vm->gc.state != GC_SPROPAGATE) { /* it may not be swept */
+                gc_setwhite(vm, obj);
+            }
         }
     }
 }
@@ -136,7 +335,7 @@ static void mark_gray_var(bvm *vm, bvalue *value)
     }
 }
 
-static void mark_map(bvm *vm, bgcobject *obj)
+static int mark_map(bvm *vm, bgcobject *obj)
 {
     bmap *map = cast_map(obj);
     gc_try (map != NULL) {
@@ -152,9 +351,10 @@ static void mark_map(bvm *vm, bgcobject *obj)
             mark_gray_var(vm, val);
         }
     }
+    return be_map_size(map) + 1;
 }
 
-static void mark_list(bvm *vm, bgcobject *obj)
+static int mark_list(bvm *vm, bgcobject *obj)
 {
     blist *list = cast_list(obj);
     gc_try (list != NULL) {
@@ -165,9 +365,10 @@ static void mark_list(bvm *vm, bgcobject *obj)
             mark_gray_var(vm, val);
         }
     }
+    return be_list_count(list) + 1;
 }
 
-static void mark_proto(bvm *vm, bgcobject *obj)
+static int mark_proto(bvm *vm, bgcobject *obj)
 {
     bproto *p = cast_proto(obj);
     gc_try (p != NULL) {
@@ -181,18 +382,28 @@ static void mark_proto(bvm *vm, bgcobject *obj)
         for (count = p->nproto; count--; ++ptab) {
             mark_gray(vm, gc_object(*ptab));
         }
+        if (p->mcache) { /* cached classes and modules */
+            bmcache *mc = p->mcache;
+            for (count = p->codesize; count--; ++mc) {
+                mark_gray(vm, mc->owner);
+            }
+        }
+        if (p->closure) {
+            mark_gray(vm, gc_object(p->closure));
+        }
         if (p->name) {
-            gc_setdark(p->name);
+            mark_gray(vm, gc_object(p->name));
         }
 #if BE_DEBUG_RUNTIME_INFO
         if (p->source) {
-            gc_setdark(p->source);
+            mark_gray(vm, gc_object(p->source));
         }
 #endif
     }
+    return p->nconst + p->nproto + 1;
 }
 
-static void mark_closure(bvm *vm, bgcobject *obj)
+static int mark_closure(bvm *vm, bgcobject *obj)
 {
     bclosure *cl = cast_closure(obj);
     gc_try (cl != NULL) {
@@ -206,9 +417,10 @@ static void mark_closure(bvm *vm, bgcobject *obj)
         }
         mark_gray(vm, gc_object(cl->proto));
     }
+    return cl->nupvals + 1;
 }
 
-static void mark_ntvclos(bvm *vm, bgcobject *obj)
+static int mark_ntvclos(bvm *vm, bgcobject *obj)
 {
     bntvclos *f = cast_ntvclos(obj);
     gc_try (f != NULL) {
@@ -221,9 +433,10 @@ static void mark_ntvclos(bvm *vm, bgcobject *obj)
             }
         }
     }
+    return f->nupvals + 1;
 }
 
-static void mark_class(bvm *vm, bgcobject *obj)
+static int mark_class(bvm *vm, bgcobject *obj)
 {
     bclass *c = cast_class(obj);
     gc_try (c != NULL) {
@@ -231,9 +444,10 @@ static void mark_class(bvm *vm, bgcobject *obj)
         mark_gray(vm, gc_object(be_class_members(c)));
         mark_gray(vm, gc_object(be_class_super(c)));
     }
+    return 1;
 }
 
-static void mark_instance(bvm *vm, bgcobject *obj)
+static int mark_instance(bvm *vm, bgcobject *obj)
 {
     binstance *o = cast_instance(obj);
     gc_try (o != NULL) {
@@ -246,15 +460,17 @@ static void mark_instance(bvm *vm, bgcobject *obj)
             mark_gray_var(vm, var);
         }
     }
+    return be_instance_member_count(o) + 1;
 }
 
-static void mark_module(bvm *vm, bgcobject *obj)
+static int mark_module(bvm *vm, bgcobject *obj)
 {
     bmodule *o = cast_module(obj);
     gc_try (o != NULL) {
         vm->gc.gray = o->gray; /* remove object from gray list */
         mark_gray(vm, gc_object(o->table));
     }
+    return 1;
 }
 
 static void free_proto(bvm *vm, bgcobject *obj)
@@ -265,6 +481,12 @@ static void free_proto(bvm *vm, bgcobject *obj)
         be_free(vm, proto->ktab, proto->nconst * sizeof(bvalue));
         be_free(vm, proto->ptab, proto->nproto * sizeof(bproto*));
         be_free(vm, proto->code, proto->codesize * sizeof(binstruction));
+        if (proto->mcache) {
+            be_free(vm, proto->mcache, proto->codesize * sizeof(bmcache));
+        }
+#if BE_USE_JIT
+        be_jit_free(vm, proto);
+#endif
 #if BE_DEBUG_RUNTIME_INFO
         be_free(vm, proto->lineinfo, proto->nlineinfo * sizeof(blineinfo));
 #endif
@@ -283,7 +505,7 @@ static void free_closure(bvm *vm, bgcobject *obj)
                 --uv->refcnt;
             }
             /* delete non-referenced closed upvalue */
-            if (uv->value == &uv->u.value && !uv->refcnt) {
+            if (uv->value == &uv->closed && !uv->refcnt) {
                 be_free(vm, uv, sizeof(bupval));
             }
         }
@@ -303,20 +525,35 @@ static void free_ntvclos(bvm *vm, bgcobject *obj)
     }
 }
 
-static void free_lstring(bvm *vm, bgcobject *obj)
+static void free_instance(bvm *vm, bgcobject *obj)
+{
+    binstance *o = cast_instance(obj);
+    gc_try (o != NULL) {
+        /* the class may be freed before the instance */
+        be_free(vm, o, sizeof(binstance) + sizeof(bvalue) * (o->nvar - 1));
+    }
+}
+
+/* the short strings are only freed here when they are in the GC pages,
+ * they are removed from the string table */
+static void free_string(bvm *vm, bgcobject *obj)
 {
-    blstring *ls = gc_cast(obj, BE_STRING, blstring);
-    gc_try (ls != NULL)  {
-        be_free(vm, ls, sizeof(blstring) + ls->llen + 1);
+    bstring *s = cast_str(obj);
+    gc_try (s != NULL)  {
+        if (s->slen == 255) {
+            be_free(vm, s, sizeof(blstring) + cast(blstring*, s)->llen + 1);
+        } else {
+            be_gcfreestr(vm, s);
+        }
     }
 }
 
 static void free_object(bvm *vm, bgcobject *obj)
 {
     switch (obj->type) {
-    case BE_STRING: free_lstring(vm, obj); break; /* long string */
-    case BE_CLASS: be_free(vm, obj, sizeof(bclass)); break;
-    case BE_INSTANCE: be_free(vm, obj, sizeof(binstance)); break;
+    case BE_STRING: free_string(vm, obj); break;
+    case BE_CLASS: be_class_free(vm, cast_class(obj)); break;
+    case BE_INSTANCE: free_instance(vm, obj); break;
     case BE_MAP: be_map_delete(vm, cast_map(obj)); break;
     case BE_LIST: be_list_delete(vm, cast_list(obj)); break;
     case BE_CLOSURE: free_closure(vm, obj); break;
@@ -360,103 +597,517 @@ static void premark_stack(bvm *vm)
 
 static void premark_fixed(bvm *vm)
 {
-    bgcobject *node = vm->gc.list;
-    for (; node; node = node->next) {
-        if (gc_isfixed(node) && gc_iswhite(node)) {
-            mark_gray(vm, node);
-        }
+    bgcobject **p = be_stack_base(&vm->gc.fixed);
+    bgcobject **end = p + be_stack_count(&vm->gc.fixed);
+    for (; p < end; ++p) {
+        mark_gray(vm, *p);
+    }
+}
+
+/* scan the first object of the gray list, the result is the amount
+ * of the work done */
+static int propagate_mark(bvm *vm)
+{
+    bgcobject *obj = vm->gc.gray;
+    be_assert(gc_isgray(obj));
+    gc_setdark(obj);
+    switch (obj->type) {
+    case BE_CLASS: return mark_class(vm, obj);
+    case BE_PROTO: return mark_proto(vm, obj);
+    case BE_INSTANCE: return mark_instance(vm, obj);
+    case BE_MAP: return mark_map(vm, obj);
+    case BE_LIST: return mark_list(vm, obj);
+    case BE_CLOSURE: return mark_closure(vm, obj);
+    case BE_NTVCLOS: return mark_ntvclos(vm, obj);
+    case BE_MODULE: return mark_module(vm, obj);
+    default:
+        be_assert(0); /* error */
+        return 1;
     }
 }
 
 static void mark_unscanned(bvm *vm)
 {
     while (vm->gc.gray) {
-        bgcobject *obj = vm->gc.gray;
-        if (obj && !gc_isdark(obj) && !gc_isconst(obj)) {
-            gc_setdark(obj);
-            switch (var_type(obj)) {
-            case BE_CLASS: mark_class(vm, obj); break;
-            case BE_PROTO: mark_proto(vm, obj); break;
-            case BE_INSTANCE: mark_instance(vm, obj); break;
-            case BE_MAP: mark_map(vm, obj); break;
-            case BE_LIST: mark_list(vm, obj); break;
-            case BE_CLOSURE: mark_closure(vm, obj); break;
-            case BE_NTVCLOS: mark_ntvclos(vm, obj); break;
-            case BE_MODULE: mark_module(vm, obj); break;
-            default:
-                be_assert(0); /* error */
-                break;
-            }
+        propagate_mark(vm);
+    }
+}
+
+/* the instances in the finalizer queue are kept until their
+ * finalizers are called */
+static void premark_tobefnz(bvm *vm)
+{
+    bgcobject **p = be_stack_base(&vm->gc.tobefnz);
+    bgcobject **end = p + be_stack_count(&vm->gc.tobefnz);
+    for (; p < end; ++p) {
+        mark_gray(vm, *p);
+    }
+}
+
+/* move the unreachable instances having a finalizer to the finalizer
+ * queue, they and the objects they refer to are marked again, so none
+ * of them is freed before the finalizer is called */
+static void separate_finobj(bvm *vm)
+{
+    bstack *set = &vm->gc.finobj;
+    bgcobject **base = be_stack_base(set), **kept = base, **p = base;
+    bgcobject **end = base + be_stack_count(set);
+    for (; p < end; ++p) {
+        if (gc_iswhite(*p)) {
+            be_stack_push(vm, &vm->gc.tobefnz, p);
+            mark_gray(vm, *p);
+        } else {
+            *kept++ = *p;
         }
     }
+    be_vector_resize(vm, set, cast_int(kept - base));
+    mark_unscanned(vm);
 }
 
-static void destruct_object(bvm *vm, bgcobject *obj)
+/* call the finalizers in the queue. the finalizers may reallocate the
+ * stack, so they are called by the interpreter at the safe points, and
+ * the GC does not run in them */
+void be_gc_finalize(bvm *vm)
 {
-    if (vm->gc.status & GC_ALLOC) {
-        return; /* no destructor is called during the allocation. */
+    bstack *queue = &vm->gc.tobefnz;
+    if (vm->gc.status & (GC_ALLOC | GC_HALT)) {
+        return;
     }
-    if (obj->type == BE_INSTANCE) {
+    while (be_stack_count(queue)) {
+        binstance *ins = *(binstance**)be_stack_top(queue);
         int type;
-        binstance *ins = cast_instance(obj);
-        /* does not GC when creating the string "deinit". */
-        type = be_instance_member(ins, be_newstr(vm, "deinit"), vm->top);
-        be_incrtop(vm);
+        be_stack_pop(queue);
+        type = be_instance_opmethod(vm, ins, OM_DEINIT, vm->top);
         if (basetype(type) == BE_FUNCTION) {
-            be_dofunc(vm, vm->top - 1, 1);
+            int top = cast_int(vm->top - vm->stack), res;
+            var_setinstance(vm->top + 1, ins);
+            vm->top += 2;
+            vm->gc.status |= GC_HALT;
+            /* the stack may be reallocated by the call */
+            res = be_protectedcall(vm, vm->stack + top, 1);
+            vm->gc.status &= ~GC_HALT;
+            if (res && vm->errjmp) { /* raise the error out of the GC */
+                be_throw(vm, res);
+            }
+            vm->top = vm->stack + top;
         }
-        be_stackpop(vm, 1);
     }
 }
 
-static void destruct_white(bvm *vm)
+void be_gc_addfinalizer(bvm *vm, bgcobject *obj)
+{
+    be_stack_push(vm, &vm->gc.finobj, &obj);
+}
+
+/* the fixed objects stay young, though the major collections make all
+ * survivors in the GC pages old */
+static void reset_fixedlist(bvm *vm)
 {
-    bgcobject *node = vm->gc.list;
-    /* since the destructor may allocate objects, we must first suspend the GC */
-    vm->gc.status |= GC_HALT; /* mark GC is halt */
-    while (node) {
-        if (gc_iswhite(node)) {
-            destruct_object(vm, node);
+    bgcobject **p = be_stack_base(&vm->gc.fixed);
+    bgcobject **end = p + be_stack_count(&vm->gc.fixed);
+    for (; p < end; ++p) {
+        gc_clearold(*p);
+        gc_setwhite(vm, *p);
+    }
+}
+
+/* begin a collection cycle by marking the root set */
+static void start_cycle(bvm *vm)
+{
+    premark_global(vm); /* global objects */
+    premark_stack(vm); /* stack objects */
+    premark_fixed(vm);
+    premark_tobefnz(vm);
+    vm->gc.state = GC_SPROPAGATE;
+}
+
+/* finish the marking without interruption. the roots are not
+ * protected by the write barriers, so they are marked again */
+static void atomic(bvm *vm)
+{
+    struct bgc *gc = &vm->gc;
+    be_assert(gc->gray == NULL);
+    gc->gray = gc->grayagain;
+    gc->grayagain = NULL;
+    premark_global(vm);
+    premark_stack(vm);
+    premark_tobefnz(vm);
+    mark_unscanned(vm);
+    separate_finobj(vm);
+    /* the objects allocated from now on get the other white, so
+     * the objects still having the current white are dead */
+    gc->white ^= GC_WHITES;
+    gc->sweep = 0;
+#if BE_USE_MEM_POOL
+    gc->sweeppage = vm->pool.gcpages; /* the new pages are not swept */
+#endif
+    gc->sweepid++; /* all pages are pending */
+    gc->state = GC_SSWEEP;
+}
+
+#if BE_USE_MEM_POOL
+static int sweep_page(bvm *vm, bgcpage *page);
+#endif
+
+/* the collection cycle is finished */
+static void end_cycle(bvm *vm)
+{
+    be_gcstrtab_shrink(vm);
+    reset_fixedlist(vm);
+    vm->gc.threshold = next_threshold(vm->gc);
+    vm->gc.state = GC_SPAUSE;
+}
+
+/* sweep a GC page or an object of the set, the result is the amount
+ * of the work done. a dead object is replaced by the last one of the
+ * set, which is swept by the next step */
+static int sweep_step(bvm *vm)
+{
+    struct bgc *gc = &vm->gc;
+    bstack *set = &gc->objects;
+#if BE_USE_MEM_POOL
+    bgcpage *page = gc->sweeppage;
+    if (page) { /* the pages are swept before the list */
+        int count = sweep_page(vm, page);
+        gc->sweeppage = page->next;
+        be_mempool_gcrelease(vm, page);
+        return count + 1;
+    }
+#endif
+    if (gc->sweep < be_stack_count(set)) {
+        bgcobject **p = be_vector_at(set, gc->sweep), *obj = *p;
+        if (gc_isdead(vm, obj)) {
+            *p = *(bgcobject**)be_stack_top(set);
+            be_stack_pop(set);
+            free_object(vm, obj);
+        } else {
+            gc_setwhite(vm, obj);
+            gc->sweep++;
+        }
+    } else if (BE_USE_MEM_POOL) { /* the short strings are in the pages */
+        end_cycle(vm);
+    } else {
+        gc->strindex = 0;
+        gc->state = GC_SSWEEPSTR;
+    }
+    return 1;
+}
+
+static int sweepstr_step(bvm *vm)
+{
+    struct bgc *gc = &vm->gc;
+    int count = be_gcstrtab(vm, gc->strindex++);
+    if (count < 0) { /* the cycle is finished */
+        end_cycle(vm);
+        return 1;
+    }
+    return count + 1;
+}
+
+/* run the collection until the next phase or object, the result is
+ * the amount of the work done */
+static int single_step(bvm *vm)
+{
+    switch (vm->gc.state) {
+    case GC_SPAUSE:
+        start_cycle(vm);
+        return 1;
+    case GC_SPROPAGATE:
+        if (vm->gc.gray) {
+            return propagate_mark(vm);
         }
-        node = node->next;
+        atomic(vm);
+        return 1;
+    case GC_SSWEEP:
+        return sweep_step(vm);
+    default:
+        return sweepstr_step(vm);
+    }
+}
+
+static void incremental_step(bvm *vm)
+{
+    int work = vm->gc.stepsize;
+    /* the collection is not reentrant */
+    vm->gc.status |= GC_HALT;
+    do {
+        work -= single_step(vm);
+    } while (work > 0 && vm->gc.state != GC_SPAUSE);
+    vm->gc.status &= ~GC_HALT;
+}
+
+/* scan the remembered objects, and remove the objects which have no
+ * young object from the remembered set */
+static void mark_remembered(bvm *vm)
+{
+    bstack *set = &vm->gc.remember;
+    bgcobject **base = be_stack_base(set), **kept = base, **p = base;
+    bgcobject **end = base + be_stack_count(set);
+    for (; p < end; ++p) {
+        bgcobject *obj = *p, **link = gray_link(obj);
+        be_assert(gc_isold(obj) && gc_isgray(obj));
+        *link = vm->gc.gray;
+        vm->gc.gray = obj;
+        vm->gc.status &= ~GC_YOUNG;
+        propagate_mark(vm); /* scan the object without its children */
+        if (vm->gc.status & GC_YOUNG) {
+            gc_setgray(obj);
+            *kept++ = obj;
+        }
+    }
+    be_vector_resize(vm, set, cast_int(kept - base));
+}
+
+/* the survivors of a generational collection grow older, the result
+ * is true if the object is old */
+static bbool survive(bvm *vm, bgcobject *obj)
+{
+    int age = gc_age(obj) + 1;
+    if (gc_isold(obj)) { /* promoted by a barrier */
+        return btrue;
+    }
+    if (vm->gc.status & GC_MAJOR) { /* all survivors become old */
+        gc_setold(obj);
+        gc_setdark(obj);
+        return btrue;
+    }
+    if (age >= BE_GC_PROMOTE_AGE) {
+        promote(vm, obj);
+        return btrue;
+    }
+    gc_setage(obj, age);
+    gc_setwhite(vm, obj);
+    return bfalse;
+}
+
+void be_gc_survive(bvm *vm, bgcobject *obj)
+{
+    if (vm->gc.state == GC_SGENERATIONAL) {
+        survive(vm, obj);
+    } else {
+        gc_setwhite(vm, obj);
     }
-    vm->gc.status &= ~GC_HALT; /* reset GC halt flag */
 }
 
-static void delete_white(bvm *vm)
+#if BE_USE_MEM_POOL
+/* free the objects not marked in a GC page, the bitmaps are scanned
+ * instead of the objects. the marks of the survivors are cleared, but
+ * in the generational mode, the old objects stay marked and the young
+ * survivors grow older. the result is the count of the objects freed */
+static int sweep_page(bvm *vm, bgcpage *page)
 {
-    bgcobject *node, *prev, *next;
-    for (node = vm->gc.list, prev = node; node; node = next) {
-        next = node->next;
-        if (gc_iswhite(node)) {
-            if (node == vm->gc.list) { /* first node */
-                vm->gc.list = node->next;
-                prev = node->next;
-            } else { /* not first node */
-                prev->next = next;
+    struct bgc *gc = &vm->gc;
+    int i, count = 0, young = 0;
+    for (i = 0; i < MEM_PAGE_WORDS; ++i) {
+        uint32_t dead = page->alloc[i] & ~page->mark[i], survivors;
+        for (; dead; dead &= dead - 1) {
+            free_object(vm, page_object(page, i * 32 + lowbit(dead)));
+            ++count;
+        }
+        if (gc->state != GC_SGENERATIONAL) {
+            page->mark[i] = 0;
+        } else if (gc->status & GC_MAJOR) { /* all survivors become old */
+            page->old[i] = page->mark[i];
+        } else {
+            survivors = page->mark[i] & ~page->old[i];
+            for (; survivors; survivors &= survivors - 1) {
+                bgcobject *obj = page_object(page, i * 32 + lowbit(survivors));
+                if (!gc_isfixed(obj)) { /* the fixed objects stay young */
+                    survive(vm, obj);
+                }
+            }
+        }
+        young |= page->alloc[i] != page->old[i];
+    }
+    page->young = gc->state == GC_SGENERATIONAL && young;
+    page->sweepid = gc->sweepid;
+    return count;
+}
+
+/* sweep the GC pages in a generational collection. the minor collections
+ * only sweep the young pages, as the pages of the old objects have no
+ * object to be freed. the objects become young only when they are
+ * allocated or fixed, and the fixed objects are not swept */
+static void sweep_genpages(bvm *vm)
+{
+    bstack *set = &vm->gc.youngpages;
+    bgcpage *page, *next;
+    if (vm->gc.status & GC_MAJOR) {
+        be_stack_clear(set);
+        for (page = vm->pool.gcpages; page; page = next) {
+            next = page->next; /* the page may be released */
+            sweep_page(vm, page);
+            if (page->young) {
+                be_stack_push(vm, set, &page);
+            }
+            be_mempool_gcrelease(vm, page);
+        }
+    } else {
+        bgcpage **base = be_stack_base(set), **kept = base, **p = base;
+        bgcpage **end = base + be_stack_count(set);
+        for (; p < end; ++p) {
+            sweep_page(vm, *p);
+            if ((*p)->young) {
+                *kept++ = *p;
             }
-            free_object(vm, node);
+            be_mempool_gcrelease(vm, *p);
+        }
+        be_vector_resize(vm, set, cast_int(kept - base));
+    }
+}
+#endif
+
+/* sweep the young short strings, so the minor collections need not
+ * walk the whole string table */
+static void sweep_youngstr(bvm *vm)
+{
+    bstack *set = &vm->gc.youngstr;
+    bgcobject **base = be_stack_base(set), **kept = base, **p = base;
+    bgcobject **end = base + be_stack_count(set);
+    for (; p < end; ++p) {
+        bgcobject *obj = *p;
+        if (gc_isfixed(obj)) {
+            continue; /* swept by the major collections */
+        }
+        if (gc_isdead(vm, obj)) {
+            be_gcfreestr(vm, cast_str(obj));
+        } else if (!survive(vm, obj)) {
+            *kept++ = obj;
+        }
+    }
+    be_vector_resize(vm, set, cast_int(kept - base));
+}
+
+/* make all objects young and white, the old objects are moved back to
+ * the object set, and the bitmaps of the GC pages are cleared */
+static void reset_generations(bvm *vm)
+{
+    struct bgc *gc = &vm->gc;
+    bgcobject **p = be_stack_base(&gc->old), **end;
+    int i;
+#if BE_USE_MEM_POOL
+    bgcpage *page = vm->pool.gcpages;
+    for (; page; page = page->next) {
+        memset(page->mark, 0, sizeof(page->mark));
+        memset(page->old, 0, sizeof(page->old));
+        page->young = 0;
+    }
+    be_stack_clear(&gc->youngpages);
+#endif
+    end = p + be_stack_count(&gc->old);
+    for (; p < end; ++p) { /* append the old objects */
+        be_stack_push(vm, &gc->objects, p);
+    }
+    be_stack_clear(&gc->old);
+    p = be_stack_base(&gc->objects);
+    end = p + be_stack_count(&gc->objects);
+    for (; p < end; ++p) {
+        (*p)->marked &= ~GC_OLD;
+        gc_setage(*p, 0);
+        gc_setwhite(vm, *p);
+    }
+    for (i = 0; !BE_USE_MEM_POOL && i < vm->strtab.size; ++i) {
+        bstring *s = vm->strtab.table[i];
+        for (; s; s = cast(bsstring*, s)->next) {
+            s->marked &= ~GC_OLD;
+            gc_setage(s, 0);
+            gc_setwhite(vm, gc_object(s));
+        }
+    }
+    be_stack_clear(&gc->remember);
+    be_stack_clear(&gc->youngstr);
+}
+
+/* a minor collection only marks and sweeps the young objects, the old
+ * objects are assumed to be alive. a major collection marks all
+ * objects, and all the survivors become old */
+static void generational_step(bvm *vm)
+{
+    struct bgc *gc = &vm->gc;
+    bgcobject **base, **kept, **p, **end;
+    int i = 0;
+    gc->status |= GC_HALT;
+    if (gc->status & GC_MAJOR) {
+        reset_generations(vm);
+    }
+    premark_global(vm);
+    premark_stack(vm);
+    premark_fixed(vm);
+    premark_tobefnz(vm);
+    mark_remembered(vm);
+    mark_unscanned(vm);
+    separate_finobj(vm);
+    gc->white ^= GC_WHITES;
+    base = kept = p = be_stack_base(&gc->objects);
+    end = base + be_stack_count(&gc->objects);
+    for (; p < end; ++p) {
+        bgcobject *obj = *p;
+        if (gc_isfixed(obj)) { /* the fixed objects stay young */
+            *kept++ = obj;
+        } else if (gc_isdead(vm, obj)) {
+            free_object(vm, obj);
+        } else if (survive(vm, obj)) { /* move to the old set */
+            be_stack_push(vm, &gc->old, &obj);
         } else {
-            gc_setwhite(node);
-            prev = node;
+            *kept++ = obj;
         }
     }
+    be_vector_resize(vm, &gc->objects, cast_int(kept - base));
+#if BE_USE_MEM_POOL
+    sweep_genpages(vm);
+#endif
+    if (gc->status & GC_MAJOR) {
+        while (!BE_USE_MEM_POOL && be_gcstrtab(vm, i++) >= 0);
+        be_stack_clear(&gc->youngstr); /* all strings are old */
+        be_gcstrtab_shrink(vm);
+    } else {
+        sweep_youngstr(vm);
+    }
+    reset_fixedlist(vm);
+    if (gc->status & GC_MAJOR) {
+        gc->majorbase = gc->usage;
+        gc->status &= ~GC_MAJOR;
+    } else if (gc->usage > gc->majorbase * (gc->steprate + 100) / 100) {
+        gc->status |= GC_MAJOR; /* the old generation has grown */
+    }
+    gc->threshold = gc->usage + gc->majorbase * GC_MINOR_RATE / 100;
+    gc->status &= ~GC_HALT;
 }
 
-static void reset_fixedlist(bvm *vm)
+void be_gc_setgenerational(bvm *vm, int generational)
 {
-    bgcobject *node;
-    for (node = vm->gc.fixed; node; node = node->next) {
-        if (gc_isdark(node)) {
-            gc_setwhite(node);
+    struct bgc *gc = &vm->gc;
+    if (generational && gc->state != GC_SGENERATIONAL) {
+        gc->status |= GC_HALT;
+        while (gc->state != GC_SPAUSE) { /* finish the running cycle */
+            single_step(vm);
         }
+        gc->status &= ~GC_HALT;
+        gc->status |= GC_MAJOR;
+        gc->state = GC_SGENERATIONAL;
+    } else if (!generational && gc->state == GC_SGENERATIONAL) {
+        gc->status |= GC_HALT;
+        reset_generations(vm);
+        gc->status &= ~(GC_HALT | GC_MAJOR);
+        gc->state = GC_SPAUSE;
     }
 }
 
 void be_gc_auto(bvm *vm)
 {
-    if (vm->gc.status & GC_PAUSE && vm->gc.usage > vm->gc.threshold) {
-        be_gc_collect(vm);
+    struct bgc *gc = &vm->gc;
+    if (gc->status & GC_PAUSE && !(gc->status & GC_HALT)) {
+        if (gc->state == GC_SGENERATIONAL) {
+            if (gc->usage > gc->threshold) {
+                generational_step(vm);
+            }
+        } else if (gc->state != GC_SPAUSE || gc->usage > gc->threshold) {
+            if (gc->stepsize) {
+                incremental_step(vm);
+            } else {
+                be_gc_collect(vm);
+            }
+        }
     }
 }
 
@@ -465,18 +1116,19 @@ void be_gc_collect(bvm *vm)
     if (vm->gc.status & GC_HALT) {
         return; /* the GC cannot run for some reason */
     }
-    /* step 1: set root-set reference objects to unscanned */
-    premark_global(vm); /* global objects */
-    premark_stack(vm); /* stack objects */
-    premark_fixed(vm);
-    /* step 2: set unscanned objects to black */
-    mark_unscanned(vm);
-    /* step 3: destruct and delete unreachable objects */
-    destruct_white(vm);
-    delete_white(vm);
-    be_gcstrtab(vm);
-    /* step 4: reset the fixed objects */
-    reset_fixedlist(vm);
-    /* step 5: calculate the next GC threshold */
-    vm->gc.threshold = next_threshold(vm->gc);
+    if (vm->gc.state == GC_SGENERATIONAL) {
+        vm->gc.status |= GC_MAJOR;
+        generational_step(vm);
+        return;
+    }
+    vm->gc.status |= GC_HALT;
+    /* finish the running cycle, the objects died during it are freed
+     * by the next one */
+    while (vm->gc.state != GC_SPAUSE) {
+        single_step(vm);
+    }
+    do { /* run a complete cycle */
+        single_step(vm);
+    } while (vm->gc.state != GC_SPAUSE);
+    vm->gc.status &= ~GC_HALT;
 }
@@ -2,6 +2,7 @@
 #define BE_GC_H
 
 #include "be_object.h"
+#include "be_mem.h"
 
 #define BE_GCOBJECT         BE_STRING
 
@@ -17,46 +18,141 @@
 #define cast_list(o)        gc_cast(o, BE_LIST, blist)
 #define cast_module(o)      gc_cast(o, BE_MODULE, bmodule)
 
-#define gc_ismark(o, m)     (((o)->marked & 0x03) == m)
-#define gc_iswhite(o)       gc_ismark((o), GC_WHITE)
-#define gc_isgray(o)        gc_ismark((o), GC_GRAY)
-#define gc_isdark(o)        gc_ismark((o), GC_DARK)
+#if BE_USE_MEM_POOL
+#define gc_ispaged(o)       (((o)->marked & GC_PAGED) != 0)
+#else
+#define gc_ispaged(o)       0
+#endif
+#define gc_page(o)          be_gcpage(o)
+#define gc_pagetest(o, map) be_bitmap_test(gc_page(o)->map, be_gcpage_bit(o))
+/* a page is pending while the running sweep has not reached it */
+#define gc_pagepending(vm, p) \
+    ((vm)->gc.state == GC_SSWEEP && (p)->sweepid != (vm)->gc.sweepid)
+
+/* the mark of an object in a GC page is in the bitmap of the page, and
+ * the color in its header only tells gray from dark */
+#define gc_ismark(o, m)     (((o)->marked & 0x03) == (m))
+#define gc_ismarked(o) \
+    (gc_ispaged(o) ? gc_pagetest((o), mark) : \
+        gc_ismark((o), GC_GRAY) || gc_ismark((o), GC_DARK))
+#define gc_iswhite(o)       (!gc_ismarked(o))
+#define gc_isgray(o)        (gc_ismark((o), GC_GRAY) && gc_ismarked(o))
+#define gc_isdark(o)        (!gc_ismark((o), GC_GRAY) && gc_ismarked(o))
+/* the objects still having the other white, or the objects not marked
+ * in a pending page, were not reached by the last marking, they are
+ * freed when the collection cycle is finished */
+#define gc_isdead(vm, o) \
+    (gc_ispaged(o) ? \
+        !gc_pagetest((o), mark) && gc_pagepending((vm), gc_page(o)) : \
+        gc_ismark((o), (vm)->gc.white ^ GC_WHITES) && !gc_isconst(o))
 
 #define gc_setmark(o, m) \
 if (!gc_isconst(o)) { \
     (o)->marked &= ~0x03; \
     (o)->marked |= (m) & 0x03; \
+    if (gc_ispaged(o)) { \
+        if ((m) == GC_GRAY || (m) == GC_DARK) { \
+            be_bitmap_set(gc_page(o)->mark, be_gcpage_bit(o)); \
+        } else { \
+            be_bitmap_clear(gc_page(o)->mark, be_gcpage_bit(o)); \
+        } \
+    } \
 }
 
-#define gc_setwhite(o)      gc_setmark((o), GC_WHITE)
+/* the objects in the pages not yet swept are kept by their marks */
+#define gc_setwhite(vm, o) \
+    gc_setmark((o), gc_ispaged(o) && gc_pagepending((vm), gc_page(o)) ? \
+        GC_DARK : (vm)->gc.white)
 #define gc_setgray(o)       gc_setmark((o), GC_GRAY)
 #define gc_setdark(o)       gc_setmark((o), GC_DARK)
 #define gc_isfixed(o)       (((o)->marked & GC_FIXED) != 0)
 #define gc_setfixed(o)      ((o)->marked |= GC_FIXED)
 #define gc_clearfixed(o)    ((o)->marked &= ~GC_FIXED)
 #define gc_isconst(o)       (((o)->marked & GC_CONST) != 0)
+/* the old objects in a GC page are in the bitmap of the page */
+#define gc_isold(o) \
+    (gc_ispaged(o) ? gc_pagetest((o), old) : ((o)->marked & GC_OLD) == GC_OLD)
+#define gc_setold(o) \
+if (gc_ispaged(o)) { \
+    be_bitmap_set(gc_page(o)->old, be_gcpage_bit(o)); \
+} else { \
+    (o)->marked |= GC_OLD; \
+}
+#define gc_clearold(o) \
+if (gc_ispaged(o)) { \
+    be_bitmap_clear(gc_page(o)->old, be_gcpage_bit(o)); \
+} else { \
+    (o)->marked &= ~GC_OLD; \
+}
+#define gc_age(o)           ((o)->marked >> 5)
+#define gc_setage(o, a) \
+    ((o)->marked = (bbyte)(((o)->marked & 0x1F) | ((a) << 5)))
+
+/* some unreachable instances are waiting for their finalizers */
+#define be_gc_hasfinalizer(vm) \
+    ((vm)->gc.tobefnz.end >= (vm)->gc.tobefnz.data)
 
-#define be_isgctype(t)      (t >= BE_GCOBJECT)
+#define be_isgctype(t)      ((t) >= BE_GCOBJECT && (t) != BE_LNTVFUNC)
 #define be_isgcobj(o)       be_isgctype(var_type(o))
 #define be_gcnew(v, t, s)   be_newgcobj((v), (t), sizeof(s))
 
+/* the write barrier of the object 'o', it must be used when a reference
+ * is stored into 'o'. an object already scanned by the running marking
+ * will be scanned again before the marking is finished, and an old
+ * object is remembered until the next minor collection */
+#define be_gc_barrier(vm, o) \
+if ((vm)->gc.state >= GC_SPROPAGATE && gc_isdark(o)) { \
+    be_gc_barrierback((vm), gc_object(o)); \
+}
+
+/* the write barrier for the value 'v' stored into an object which is
+ * not known, such as an upvalue, the value itself is marked */
+#define be_gc_barrierval(vm, v) \
+if ((vm)->gc.state >= GC_SPROPAGATE && be_isgcobj(v)) { \
+    be_gc_markval((vm), (v)); \
+}
+
 typedef enum {
     GC_WHITE = 0x00, /* unreachable object */
     GC_GRAY = 0x01,  /* unscanned object */
     GC_DARK = 0x02,  /* scanned object */
+    GC_WHITE1 = 0x03, /* the other white, see vm->gc.white */
     GC_FIXED = 0x04,
-    GC_CONST = 0x08
+    GC_CONST = 0x08,
+    GC_PAGED = 0x10, /* the object is in a GC page, see bgcpage */
+    /* survived the young generation, the age of a young object is
+     * in bits 5-7, and an old object has the age 7 */
+    GC_OLD = 0xE0
 } bgcmark;
 
+#define GC_WHITES           (GC_WHITE ^ GC_WHITE1)
+
+/* the phases of a collection cycle, the write barriers are enabled
+ * in the phases from GC_SPROPAGATE */
+typedef enum {
+    GC_SPAUSE,      /* no collection is running */
+    GC_SSWEEP,      /* freeing the dead objects */
+    GC_SSWEEPSTR,   /* freeing the dead short strings */
+    GC_SPROPAGATE,  /* marking the reachable objects */
+    GC_SGENERATIONAL /* the generational mode, see be_gc_setgenerational */
+} bgcstate;
+
 void be_gc_init(bvm *vm);
 void be_gc_deleteall(bvm *vm);
 void be_gc_setsteprate(bvm *vm, int rate);
 void be_gc_setpause(bvm *vm, int pause);
+void be_gc_setstepsize(bvm *vm, int size);
+void be_gc_setgenerational(bvm *vm, int generational);
 size_t be_memcount(bvm *vm);
 bgcobject *be_newgcobj(bvm *vm, int type, size_t size);
 bgcobject* be_gc_newstr(bvm *vm, size_t size, int islong);
 void be_gc_fix(bvm *vm, bgcobject *obj);
 void be_gc_unfix(bvm *vm, bgcobject *obj);
+void be_gc_barrierback(bvm *vm, bgcobject *obj);
+void be_gc_markval(bvm *vm, bvalue *v);
+void be_gc_survive(bvm *vm, bgcobject *obj);
+void be_gc_addfinalizer(bvm *vm, bgcobject *obj);
+void be_gc_finalize(bvm *vm);
 void be_gc_collect(bvm *vm);
 void be_gc_auto(bvm *vm);
 
@@ -0,0 +1,591 @@
+#define _DEFAULT_SOURCE /* for mmap() and MAP_ANONYMOUS */
+#include "be_jit.h"
+
+#if BE_USE_JIT
+#include "be_opcode.h"
+#include "be_mem.h"
+#include "be_string.h"
+#include "be_vm.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+/* The baseline JIT compiler. The native code of a function is made
+ * by copying the machine code template (stencil) of each instruction
+ * and patching its holes: register offsets, immediate values and jump
+ * targets. The native code runs with these registers:
+ *
+ *   rbx: the base register of the call frame
+ *   r13: the constant table
+ *   r12: the execution budget of the VM (vm->budget)
+ *   rdx: R(A), rsi: RK(B), rdi: RK(C)
+ *
+ * An instruction without a stencil, or an operand type not handled
+ * by the stencil, leaves the native code with the index of the
+ * instruction, which is then executed by the interpreter. */
+
+#define INST_MAXSIZE        128 /* upper bound of the code of an instruction */
+#define EXIT_SIZE           10  /* mov eax, pc; jmp epilogue */
+#define FIX_MAXCOUNT        8   /* upper bound of the jumps of an instruction */
+
+#define FIX_INST            0 /* the jump to an instruction */
+#define FIX_EXIT            1 /* the jump to the exit of an instruction */
+
+#define OPND_A              0x7A /* ModRM of [rdx+disp8] */
+#define OPND_B              0x7E /* ModRM of [rsi+disp8] */
+#define OPND_C              0x7F /* ModRM of [rdi+disp8] */
+
+#define slot_offset(idx)    ((uint32_t)(idx) * (uint32_t)sizeof(bvalue))
+
+typedef int (*bjitfunc)(bvalue *reg, bvalue *ktab, void *entry, int *budget);
+
+typedef struct bjitcode {
+    bbyte *code; /* the executable memory */
+    size_t size; /* the size of the mapping */
+    uint32_t entry[1]; /* code offset of each instruction, 0 if it exits */
+} bjitcode;
+
+typedef struct {
+    uint32_t pos; /* position of the rel32 hole */
+    int kind; /* FIX_INST or FIX_EXIT */
+    int pc; /* the target instruction */
+} bjitfix;
+
+typedef struct {
+    bproto *proto;
+    bbyte *buf;
+    size_t pos;
+    uint32_t *inst; /* the code offset of each instruction */
+    bjitfix *fix;
+    int nfix;
+} bjitstate;
+
+/* push rbx; push r13; push r12; mov rbx, rdi; mov r13, rsi; mov r12, rcx; jmp rdx */
+static const bbyte st_prologue[] = {
+    0x53, 0x41, 0x55, 0x41, 0x54, 0x48, 0x89, 0xFB,
+    0x49, 0x89, 0xF5, 0x49, 0x89, 0xCC, 0xFF, 0xE2
+};
+/* pop r12; pop r13; pop rbx; ret */
+static const bbyte st_epilogue[] = { 0x41, 0x5C, 0x41, 0x5D, 0x5B, 0xC3 };
+
+/* cmp dword [r12], 0 */
+static const bbyte st_test_budget[] = { 0x41, 0x83, 0x3C, 0x24, 0x00 };
+
+/* lea rdx, [rbx+disp32] */
+static const bbyte st_lea_a[] = { 0x48, 0x8D, 0x93 };
+/* lea rsi, [rbx+disp32] and lea rsi, [r13+disp32] */
+static const bbyte st_lea_rb[] = { 0x48, 0x8D, 0xB3 };
+static const bbyte st_lea_kb[] = { 0x49, 0x8D, 0xB5 };
+/* lea rdi, [rbx+disp32] and lea rdi, [r13+disp32] */
+static const bbyte st_lea_rc[] = { 0x48, 0x8D, 0xBB };
+static const bbyte st_lea_kc[] = { 0x49, 0x8D, 0xBD };
+
+/* mov rax, [rsi]; <op> rax, [rdi]; mov [rdx], rax; mov dword [rdx+8], BE_INT */
+static const bbyte st_add_int[] = { 0x48, 0x8B, 0x06, 0x48, 0x03, 0x07 };
+static const bbyte st_sub_int[] = { 0x48, 0x8B, 0x06, 0x48, 0x2B, 0x07 };
+static const bbyte st_mul_int[] = { 0x48, 0x8B, 0x06, 0x48, 0x0F, 0xAF, 0x07 };
+static const bbyte st_store_int[] = {
+    0x48, 0x89, 0x02, 0xC7, 0x42, 0x08, BE_INT, 0x00, 0x00, 0x00
+};
+
+/* movsd xmm0, [rsi]; <op>sd xmm0, [rdi]; movsd [rdx], xmm0; mov dword [rdx+8], BE_REAL */
+static const bbyte st_add_real[] = { 0xF2, 0x0F, 0x10, 0x06, 0xF2, 0x0F, 0x58, 0x07 };
+static const bbyte st_sub_real[] = { 0xF2, 0x0F, 0x10, 0x06, 0xF2, 0x0F, 0x5C, 0x07 };
+static const bbyte st_mul_real[] = { 0xF2, 0x0F, 0x10, 0x06, 0xF2, 0x0F, 0x59, 0x07 };
+static const bbyte st_store_real[] = {
+    0xF2, 0x0F, 0x11, 0x02, 0xC7, 0x42, 0x08, BE_REAL, 0x00, 0x00, 0x00
+};
+
+/* mov rax, [rsi]; cmp rax, [rdi] */
+static const bbyte st_cmp_int[] = { 0x48, 0x8B, 0x06, 0x48, 0x3B, 0x07 };
+/* movsd xmm0, [rdi]; ucomisd xmm0, [rsi] (for < and <=) */
+static const bbyte st_cmp_real_rev[] = { 0xF2, 0x0F, 0x10, 0x07, 0x66, 0x0F, 0x2E, 0x06 };
+/* movsd xmm0, [rsi]; ucomisd xmm0, [rdi] (for > and >=) */
+static const bbyte st_cmp_real[] = { 0xF2, 0x0F, 0x10, 0x06, 0x66, 0x0F, 0x2E, 0x07 };
+
+/* mov rax, [rsi]; mov ecx, [rsi+8]; mov [rdx], rax; mov [rdx+8], ecx. the
+ * value and the type are copied separately to allow store forwarding */
+static const bbyte st_move[] = {
+    0x48, 0x8B, 0x06, 0x8B, 0x4E, 0x08, 0x48, 0x89, 0x02, 0x89, 0x4A, 0x08
+};
+/* mov dword [rdx+8], BE_NIL */
+static const bbyte st_ldnil[] = { 0xC7, 0x42, 0x08, BE_NIL, 0x00, 0x00, 0x00 };
+/* mov qword [rdx], imm32 */
+static const bbyte st_ldimm[] = { 0x48, 0xC7, 0x02 };
+/* mov dword [rdx+8], BE_BOOL */
+static const bbyte st_settype_bool[] = { 0xC7, 0x42, 0x08, BE_BOOL, 0x00, 0x00, 0x00 };
+/* mov dword [rdx+8], BE_INT */
+static const bbyte st_settype_int[] = { 0xC7, 0x42, 0x08, BE_INT, 0x00, 0x00, 0x00 };
+/* cmp dword [rdx], 0 */
+static const bbyte st_test_bool[] = { 0x83, 0x3A, 0x00 };
+
+/* mov rax, [rsi]; mov rcx, [rdi]; mov [rdx+16], rax; mov dword [rdx+24], BE_INT;
+ * mov [rdx+32], rcx; mov dword [rdx+40], BE_INT; cmp rax, rcx */
+static const bbyte st_forprep[] = {
+    0x48, 0x8B, 0x06, 0x48, 0x8B, 0x0F,
+    0x48, 0x89, 0x42, 0x10, 0xC7, 0x42, 0x18, BE_INT, 0x00, 0x00, 0x00,
+    0x48, 0x89, 0x4A, 0x20, 0xC7, 0x42, 0x28, BE_INT, 0x00, 0x00, 0x00,
+    0x48, 0x39, 0xC8
+};
+/* mov rax, [rdx+16]; cmp rax, [rdx+32] */
+static const bbyte st_forloop_test[] = {
+    0x48, 0x8B, 0x42, 0x10, 0x48, 0x3B, 0x42, 0x20
+};
+/* inc rax; mov [rdx+16], rax */
+static const bbyte st_forloop_next[] = {
+    0x48, 0xFF, 0xC0, 0x48, 0x89, 0x42, 0x10
+};
+
+/* the second opcode byte of the jcc rel32 instructions */
+#define JCC_E       0x84
+#define JCC_NE      0x85
+#define JCC_L       0x8C
+#define JCC_GE      0x8D
+#define JCC_LE      0x8E
+#define JCC_G       0x8F
+#define JCC_A       0x87
+#define JCC_AE      0x83
+
+#define emit_stencil(j, s)  emit(j, s, sizeof(s))
+
+static void emit(bjitstate *j, const bbyte *s, size_t size)
+{
+    memcpy(j->buf + j->pos, s, size);
+    j->pos += size;
+}
+
+static void emit_byte(bjitstate *j, int b)
+{
+    j->buf[j->pos++] = (bbyte)b;
+}
+
+static void emit_u32(bjitstate *j, uint32_t v)
+{
+    bbyte *p = j->buf + j->pos;
+    p[0] = (bbyte)v;
+    p[1] = (bbyte)(v >> 8);
+    p[2] = (bbyte)(v >> 16);
+    p[3] = (bbyte)(v >> 24);
+    j->pos += 4;
+}
+
+/* write the rel32 at 'pos' to jump to the code offset 'dst' */
+static void patch_rel(bjitstate *j, size_t pos, size_t dst)
+{
+    size_t save = j->pos;
+    j->pos = pos;
+    emit_u32(j, (uint32_t)(dst - (pos + 4)));
+    j->pos = save;
+}
+
+/* emit a rel32 hole which is patched after all instructions */
+static void emit_target(bjitstate *j, int kind, int pc)
+{
+    bjitfix *fix = j->fix + j->nfix++;
+    fix->pos = (uint32_t)j->pos;
+    fix->kind = kind;
+    fix->pc = pc;
+    emit_u32(j, 0);
+}
+
+/* emit a rel32 hole which is patched by patch_rel() */
+static size_t emit_label(bjitstate *j)
+{
+    size_t pos = j->pos;
+    emit_u32(j, 0);
+    return pos;
+}
+
+static void emit_jmp(bjitstate *j, int kind, int pc)
+{
+    emit_byte(j, 0xE9);
+    emit_target(j, kind, pc);
+}
+
+static void emit_jcc(bjitstate *j, int cc, int kind, int pc)
+{
+    emit_byte(j, 0x0F);
+    emit_byte(j, cc);
+    emit_target(j, kind, pc);
+}
+
+/* cmp dword [opnd+8], type; jne rel32. return the rel32 position */
+static size_t emit_guard(bjitstate *j, int opnd, int type)
+{
+    emit_byte(j, 0x83);
+    emit_byte(j, opnd);
+    emit_byte(j, 0x08);
+    emit_byte(j, type);
+    emit_byte(j, 0x0F);
+    emit_byte(j, JCC_NE);
+    return emit_label(j);
+}
+
+/* the guard leaves the native code at the instruction 'pc' */
+static void emit_guard_exit(bjitstate *j, int opnd, int type, int pc)
+{
+    emit_byte(j, 0x83);
+    emit_byte(j, opnd);
+    emit_byte(j, 0x08);
+    emit_byte(j, type);
+    emit_jcc(j, JCC_NE, FIX_EXIT, pc);
+}
+
+/* a loop back edge leaves to the interpreter at the instruction 'pc'
+ * once a budget is set, the interpreter charges the budget there */
+static void emit_budget_exit(bjitstate *j, int pc)
+{
+    emit_stencil(j, st_test_budget);
+    emit_jcc(j, JCC_NE, FIX_EXIT, pc);
+}
+
+static void load_a(bjitstate *j, binstruction ins)
+{
+    emit_stencil(j, st_lea_a);
+    emit_u32(j, slot_offset(IGET_RA(ins)));
+}
+
+static void load_b(bjitstate *j, binstruction ins)
+{
+    int b = IGET_RKB(ins);
+    if (isK(b)) {
+        emit_stencil(j, st_lea_kb);
+    } else {
+        emit_stencil(j, st_lea_rb);
+    }
+    emit_u32(j, slot_offset(KR2idx(b)));
+}
+
+static void load_bc(bjitstate *j, binstruction ins)
+{
+    int c = IGET_RKC(ins);
+    load_b(j, ins);
+    if (isK(c)) {
+        emit_stencil(j, st_lea_kc);
+    } else {
+        emit_stencil(j, st_lea_rc);
+    }
+    emit_u32(j, slot_offset(KR2idx(c)));
+}
+
+/* R(A) <- RK(B) op RK(C) for two integers or two reals */
+static void arith(bjitstate *j, binstruction ins, int pc,
+                  const bbyte *iop, size_t isize, const bbyte *rop)
+{
+    size_t l1, l2;
+    load_a(j, ins);
+    load_bc(j, ins);
+    l1 = emit_guard(j, OPND_B, BE_INT);
+    l2 = emit_guard(j, OPND_C, BE_INT);
+    emit(j, iop, isize);
+    emit_stencil(j, st_store_int);
+    emit_jmp(j, FIX_INST, pc + 1);
+    patch_rel(j, l1, j->pos);
+    patch_rel(j, l2, j->pos);
+    emit_guard_exit(j, OPND_B, BE_REAL, pc);
+    emit_guard_exit(j, OPND_C, BE_REAL, pc);
+    emit(j, rop, sizeof(st_add_real));
+    emit_stencil(j, st_store_real);
+}
+
+/* the fused relational jump, the next instruction is the jump */
+static int reljump(bjitstate *j, binstruction ins, int pc, int icc, int rcc, int rev)
+{
+    size_t l1, l2;
+    int taken, next = pc + 2;
+    binstruction jmp;
+    if (pc + 1 >= j->proto->codesize) {
+        return 0;
+    }
+    jmp = j->proto->code[pc + 1];
+    if (IGET_OP(jmp) != OP_JMP) {
+        return 0;
+    }
+    taken = pc + 2 + IGET_sBx(jmp);
+    if (!IGET_RA(ins)) { /* jump when the result is false */
+        int t = taken; taken = next; next = t;
+    }
+    load_bc(j, ins);
+    l1 = emit_guard(j, OPND_B, BE_INT);
+    l2 = emit_guard(j, OPND_C, BE_INT);
+    emit_stencil(j, st_cmp_int);
+    emit_jcc(j, icc, FIX_INST, taken);
+    emit_jmp(j, FIX_INST, next);
+    patch_rel(j, l1, j->pos);
+    patch_rel(j, l2, j->pos);
+    if (rcc) { /* unordered compares are false */
+        emit_guard_exit(j, OPND_B, BE_REAL, pc);
+        emit_guard_exit(j, OPND_C, BE_REAL, pc);
+        if (rev) {
+            emit_stencil(j, st_cmp_real_rev);
+        } else {
+            emit_stencil(j, st_cmp_real);
+        }
+        emit_jcc(j, rcc, FIX_INST, taken);
+        emit_jmp(j, FIX_INST, next);
+    } else {
+        emit_jmp(j, FIX_EXIT, pc);
+    }
+    return 1;
+}
+
+/* JMPT and JMPF of the boolean and nil values */
+static void condjump(bjitstate *j, binstruction ins, int pc, int iftrue)
+{
+    size_t l;
+    int target = pc + 1 + IGET_sBx(ins);
+    load_a(j, ins);
+    l = emit_guard(j, OPND_A, BE_BOOL);
+    emit_stencil(j, st_test_bool);
+    emit_jcc(j, iftrue ? JCC_NE : JCC_E, FIX_INST, target);
+    emit_jmp(j, FIX_INST, pc + 1);
+    patch_rel(j, l, j->pos);
+    emit_guard_exit(j, OPND_A, BE_NIL, pc);
+    emit_jmp(j, FIX_INST, iftrue ? pc + 1 : target);
+}
+
+static void forprep(bjitstate *j, binstruction ins, int pc)
+{
+    load_a(j, ins);
+    load_bc(j, ins);
+    emit_guard_exit(j, OPND_B, BE_INT, pc);
+    emit_guard_exit(j, OPND_C, BE_INT, pc);
+    emit_stencil(j, st_forprep);
+    emit_jcc(j, JCC_G, FIX_INST, pc + 1);
+    emit_stencil(j, st_store_int);
+    emit_jmp(j, FIX_INST, pc + 2);
+}
+
+static void forloop(bjitstate *j, binstruction ins, int pc)
+{
+    emit_budget_exit(j, pc);
+    load_a(j, ins);
+    emit_stencil(j, st_forloop_test);
+    emit_jcc(j, JCC_GE, FIX_INST, pc + 1);
+    emit_stencil(j, st_forloop_next);
+    emit_stencil(j, st_store_int);
+    emit_jmp(j, FIX_INST, pc + 1 + IGET_sBx(ins));
+}
+
+static void loadimm(bjitstate *j, binstruction ins, int value, const bbyte *settype)
+{
+    load_a(j, ins);
+    emit_stencil(j, st_ldimm);
+    emit_u32(j, (uint32_t)value);
+    emit(j, settype, sizeof(st_settype_int));
+}
+
+/* emit the code of the instruction, return 0 if it is not supported */
+static int instruction(bjitstate *j, binstruction ins, int pc)
+{
+    switch (IGET_OP(ins)) {
+    case OP_ADD: case OP_ADDINT: case OP_ADDREAL:
+        arith(j, ins, pc, st_add_int, sizeof(st_add_int), st_add_real);
+        break;
+    case OP_SUB: case OP_SUBINT: case OP_SUBREAL:
+        arith(j, ins, pc, st_sub_int, sizeof(st_sub_int), st_sub_real);
+        break;
+    case OP_MUL: case OP_MULINT: case OP_MULREAL:
+        arith(j, ins, pc, st_mul_int, sizeof(st_mul_int), st_mul_real);
+        break;
+    case OP_JLT: return reljump(j, ins, pc, JCC_L, JCC_A, 1);
+    case OP_JLE: return reljump(j, ins, pc, JCC_LE, JCC_AE, 1);
+    case OP_JGT: return reljump(j, ins, pc, JCC_G, JCC_A, 0);
+    case OP_JGE: return reljump(j, ins, pc, JCC_GE, JCC_AE, 0);
+    case OP_JEQ: return reljump(j, ins, pc, JCC_E, 0, 0);
+    case OP_JNE: return reljump(j, ins, pc, JCC_NE, 0, 0);
+    case OP_JCMPINT: /* compiled as the generic instruction */
+        return instruction(j, IJCMP_GENERIC(ins), pc);
+    case OP_JMP:
+        if (IGET_sBx(ins) < 0) { /* loop back edge */
+            emit_budget_exit(j, pc);
+        }
+        emit_jmp(j, FIX_INST, pc + 1 + IGET_sBx(ins));
+        break;
+    case OP_JMPT: case OP_JMPF:
+        condjump(j, ins, pc, IGET_OP(ins) == OP_JMPT);
+        break;
+    case OP_FORPREP:
+        forprep(j, ins, pc);
+        break;
+    case OP_FORLOOP:
+        forloop(j, ins, pc);
+        break;
+    case OP_MOVE:
+        load_a(j, ins);
+        load_b(j, ins);
+        emit_stencil(j, st_move);
+        break;
+    case OP_LDCONST:
+        load_a(j, ins);
+        emit_stencil(j, st_lea_kb);
+        emit_u32(j, slot_offset(IGET_Bx(ins)));
+        emit_stencil(j, st_move);
+        break;
+    case OP_LDNIL:
+        load_a(j, ins);
+        emit_stencil(j, st_ldnil);
+        break;
+    case OP_LDINT:
+        loadimm(j, ins, IGET_sBx(ins), st_settype_int);
+        break;
+    case OP_LDBOOL:
+        loadimm(j, ins, IGET_RKB(ins) != 0, st_settype_bool);
+        if (IGET_RKC(ins)) { /* skip next instruction */
+            emit_jmp(j, FIX_INST, pc + 2);
+        }
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+/* patch the jumps, the exit of an instruction is created on demand */
+static void link_code(bjitstate *j, size_t epilogue)
+{
+    int i, codesize = j->proto->codesize;
+    uint32_t *exits = j->inst + codesize;
+    for (i = 0; i < j->nfix; ++i) {
+        bjitfix *fix = j->fix + i;
+        size_t dst;
+        be_assert(fix->pc < codesize);
+        if (fix->kind == FIX_INST) {
+            dst = j->inst[fix->pc];
+        } else {
+            if (!exits[fix->pc]) {
+                exits[fix->pc] = (uint32_t)j->pos;
+                emit_byte(j, 0xB8); /* mov eax, pc */
+                emit_u32(j, (uint32_t)fix->pc);
+                emit_byte(j, 0xE9); /* jmp epilogue */
+                patch_rel(j, emit_label(j), epilogue);
+            }
+            dst = exits[fix->pc];
+        }
+        patch_rel(j, fix->pos, dst);
+    }
+}
+
+#if BE_JIT_PERF_MAP
+/* each VM appends to the map of the process, the lines are flushed
+ * at once so the lines of the VMs are not mixed */
+static void perf_map(bvm *vm, bproto *proto, bbyte *code, size_t size)
+{
+    FILE *fp = vm->perfmap;
+    if (fp == NULL) {
+        char name[64];
+        sprintf(name, "/tmp/perf-%d.map", (int)getpid());
+        fp = vm->perfmap = fopen(name, "a");
+    }
+    if (fp) {
+#if BE_DEBUG_RUNTIME_INFO
+        fprintf(fp, "%lx %lx berry:%s:%s\n", (unsigned long)(uintptr_t)code,
+            (unsigned long)size, str(proto->source), str(proto->name));
+#else
+        fprintf(fp, "%lx %lx berry:%s\n", (unsigned long)(uintptr_t)code,
+            (unsigned long)size, str(proto->name));
+#endif
+        fflush(fp);
+    }
+}
+#endif
+
+static bjitcode* compile(bvm *vm, bproto *proto)
+{
+    bjitstate j;
+    bjitcode *jit = NULL;
+    int pc, codesize = proto->codesize;
+    size_t bufsize = sizeof(st_prologue) + sizeof(st_epilogue)
+        + (size_t)codesize * (INST_MAXSIZE + EXIT_SIZE);
+    size_t fixsize = (size_t)codesize * FIX_MAXCOUNT * sizeof(bjitfix);
+    size_t instsize = (size_t)codesize * 2 * sizeof(uint32_t);
+    size_t epilogue;
+    j.proto = proto;
+    j.buf = be_malloc(vm, bufsize);
+    j.fix = be_malloc(vm, fixsize);
+    j.inst = be_malloc(vm, instsize);
+    j.pos = 0;
+    j.nfix = 0;
+    memset(j.inst, 0, instsize);
+    jit = be_malloc(vm, sizeof(bjitcode) + sizeof(uint32_t) * codesize);
+    emit_stencil(&j, st_prologue);
+    epilogue = j.pos;
+    emit_stencil(&j, st_epilogue);
+    for (pc = 0; pc < codesize; ++pc) {
+        binstruction ins = proto->code[pc];
+        size_t start = j.pos;
+        int nfix = j.nfix;
+        j.inst[pc] = (uint32_t)start;
+        if (instruction(&j, ins, pc)) {
+            jit->entry[pc] = (uint32_t)start;
+        } else { /* the interpreter executes the instruction */
+            j.pos = start;
+            j.nfix = nfix;
+            jit->entry[pc] = 0;
+            emit_jmp(&j, FIX_EXIT, pc);
+        }
+        be_assert(j.pos - start <= INST_MAXSIZE);
+        be_assert(j.nfix - nfix <= FIX_MAXCOUNT);
+    }
+    link_code(&j, epilogue);
+    jit->size = (j.pos + 4095) & ~(size_t)4095;
+    jit->code = mmap(NULL, jit->size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->code != MAP_FAILED) {
+        memcpy(jit->code, j.buf, j.pos);
+        if (mprotect(jit->code, jit->size, PROT_READ | PROT_EXEC)) {
+            munmap(jit->code, jit->size);
+            jit->code = MAP_FAILED;
+        }
+    }
+    be_free(vm, j.buf, bufsize);
+    be_free(vm, j.fix, fixsize);
+    be_free(vm, j.inst, instsize);
+    if (jit->code == MAP_FAILED) {
+        be_free(vm, jit, sizeof(bjitcode) + sizeof(uint32_t) * codesize);
+        return NULL;
+    }
+#if BE_JIT_PERF_MAP
+    perf_map(vm, proto, jit->code, j.pos);
+#endif
+    return jit;
+}
+
+binstruction* be_jit_exec(bvm *vm, bproto *proto, bvalue *reg, binstruction *ip)
+{
+    bjitcode *jit = proto->jit;
+    uint32_t entry;
+    if (jit == NULL) {
+        jit = proto->jit = compile(vm, proto);
+        if (jit == NULL) { /* keep running in the interpreter */
+            return ip;
+        }
+    }
+    entry = jit->entry[ip - proto->code];
+    if (entry) {
+        union { bbyte *p; bjitfunc f; } func;
+        func.p = jit->code;
+        return proto->code + func.f(reg, proto->ktab, jit->code + entry, &vm->budget);
+    }
+    return ip;
+}
+
+void be_jit_free(bvm *vm, bproto *proto)
+{
+    bjitcode *jit = proto->jit;
+    if (jit) {
+        munmap(jit->code, jit->size);
+        be_free(vm, jit, sizeof(bjitcode) + sizeof(uint32_t) * proto->codesize);
+        proto->jit = NULL;
+    }
+}
+
+void be_jit_delete(bvm *vm)
+{
+    if (vm->perfmap) {
+        fclose(vm->perfmap);
+        vm->perfmap = NULL;
+    }
+}
+#endif
@@ -0,0 +1,12 @@
+#ifndef BE_JIT_H
+#define BE_JIT_H
+
+#include "be_object.h"
+
+#if BE_USE_JIT
+binstruction* be_jit_exec(bvm *vm, bproto *proto, bvalue *reg, binstruction *ip);
+void be_jit_free(bvm *vm, bproto *proto);
+void be_jit_delete(bvm *vm);
+#endif
+
+#endif
@@ -49,6 +49,7 @@ bvalue* be_list_append(bvm *vm, blist *list, bvalue *value)
         list->capacity = newcap;
     }
     slot = list->data + list->count++;
+    be_gc_barrier(vm, list);
     if (value != NULL) {
         *slot = *value;
     }
@@ -76,6 +77,7 @@ bvalue* be_list_insert(bvm *vm, blist *list, int index, bvalue *value)
         data[i] = data[i - 1];
     }
     data = list->data + index;
+    be_gc_barrier(vm, list);
     if (value != NULL) {
         *data = *value;
     }
@@ -94,13 +96,23 @@ int be_list_remove(bvm *vm, blist *list, int index)
         return bfalse;
     }
     data = list->data;
-    for (i = index; i < list->count; ++i) {
+    for (i = index; i < list->count - 1; ++i) {
         data[i] = data[i + 1];
     }
     --list->count;
     return btrue;
 }
 
+void be_list_reserve(bvm *vm, blist *list, int count)
+{
+    if (count > list->capacity) {
+        int newcap = be_nextsize(count);
+        list->data = be_realloc(vm, list->data,
+            datasize(list->capacity), datasize(newcap));
+        list->capacity = newcap;
+    }
+}
+
 void be_list_resize(bvm *vm, blist *list, int count)
 {
     if (count != list->count) {
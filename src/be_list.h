@@ -21,6 +21,7 @@ bvalue* be_list_index(blist *list, int index);
 bvalue* be_list_append(bvm *vm, blist *list, bvalue *value);
 bvalue* be_list_insert(bvm *vm, blist *list, int index, bvalue *value);
 int be_list_remove(bvm *vm, blist *list, int index);
+void be_list_reserve(bvm *vm, blist *list, int count);
 void be_list_resize(bvm *vm, blist *list, int count);
 
 #endif
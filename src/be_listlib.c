@@ -1,4 +1,8 @@
 #include "be_object.h"
+#include "be_class.h"
+#include "be_list.h"
+#include "be_vm.h"
+#include "be_gc.h"
 #include <string.h>
 
 #define list_check_data(vm, argc)                       \
@@ -12,6 +16,23 @@
         be_return(vm);                                  \
     }
 
+/* the list data of the instance argv[0], or NULL when there are less
+ * than n arguments. the light methods read the arguments from argv and
+ * store the result in argv[-1]. */
+static blist* list_data(bvm *vm, bvalue *argv, int argc, int n)
+{
+    if (argc >= n && var_isinstance(argv)) {
+        binstance *obj = var_toobj(argv);
+        while (obj && obj->class != vm->listclass) { /* derived instances */
+            obj = obj->super;
+        }
+        if (obj && var_islist(be_instance_members(obj))) {
+            return var_toobj(be_instance_members(obj));
+        }
+    }
+    return NULL;
+}
+
 static int m_init(bvm *vm)
 {
     int i, argc = be_top(vm);
@@ -67,13 +88,14 @@ static int m_tostring(bvm *vm)
     be_return(vm);
 }
 
-static int m_append(bvm *vm)
+static int m_append(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    list_check_data(vm, 2);
-    be_pushvalue(vm, 2);
-    be_data_append(vm, -2);
-    be_return_nil(vm);
+    blist *list = list_data(vm, argv, argc, 2);
+    if (list) {
+        be_list_append(vm, list, argv + 1);
+    }
+    var_setnil(argv - 1);
+    return 0;
 }
 
 static int m_insert(bvm *vm)
@@ -157,17 +179,21 @@ static int item_list(bvm *vm)
     be_return(vm);
 }
 
-static int m_item(bvm *vm)
+static int m_item(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    list_check_data(vm, 2);
-    if (be_isint(vm, 2)) {
-        be_pushvalue(vm, 2);
-        be_getindex(vm, -2);
-        be_return(vm);
+    blist *list = list_data(vm, argv, argc, 2);
+    if (list && var_isint(argv + 1)) {
+        bvalue *v = be_list_index(list, var_toidx(argv + 1));
+        if (v) {
+            var_setval(argv - 1, v);
+        } else {
+            var_setnil(argv - 1);
+        }
+        return 0;
     }
-    if (be_isinstance(vm, 2)) {
+    if (list && be_isinstance(vm, 2)) { /* index by range or list */
         const char *cname = be_classname(vm, 2);
+        be_getmember(vm, 1, ".data");
         if (!strcmp(cname, "range")) {
             return item_range(vm);
         }
@@ -178,22 +204,29 @@ static int m_item(bvm *vm)
     be_return_nil(vm);
 }
 
-static int m_setitem(bvm *vm)
+static int m_setitem(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    list_check_data(vm, 3);
-    be_pushvalue(vm, 2);
-    be_pushvalue(vm, 3);
-    be_setindex(vm, -3);
-    be_return_nil(vm);
+    blist *list = list_data(vm, argv, argc, 3);
+    if (list && var_isint(argv + 1)) {
+        bvalue *dst = be_list_index(list, var_toidx(argv + 1));
+        if (dst) {
+            be_gc_barrier(vm, list);
+            var_setval(dst, argv + 2);
+        }
+    }
+    var_setnil(argv - 1);
+    return 0;
 }
 
-static int m_size(bvm *vm)
+static int m_size(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    list_check_data(vm, 1);
-    be_pushint(vm, be_data_size(vm, -1));
-    be_return(vm);
+    blist *list = list_data(vm, argv, argc, 1);
+    if (list) {
+        var_setint(argv - 1, be_list_count(list));
+    } else {
+        var_setnil(argv - 1);
+    }
+    return 0;
 }
 
 static int m_resize(bvm *vm)
@@ -240,12 +273,12 @@ static int i_next(bvm *vm)
 static int m_iter(bvm *vm)
 {
     static const bnfuncinfo members[] = {
-        { ".obj", NULL },
-        { ".iter", NULL },
-        { "init", i_init },
-        { "hasnext", i_hashnext },
-        { "next", i_next },
-        { NULL, NULL }
+        { ".obj", NULL, NULL },
+        { ".iter", NULL, NULL },
+        { "init", i_init, NULL },
+        { "hasnext", i_hashnext, NULL },
+        { "next", i_next, NULL },
+        { NULL, NULL, NULL }
     };
     be_pushclass(vm, "iterator", members);
     be_pushvalue(vm, 1);
@@ -258,18 +291,18 @@ static int m_iter(bvm *vm)
 void be_load_listlib(bvm *vm)
 {
     static const bnfuncinfo members[] = {
-        { ".data", NULL },
-        { "init", m_init },
-        { "tostring", m_tostring },
-        { "append", m_append },
-        { "insert", m_insert },
-        { "remove", m_remove },
-        { "item", m_item },
-        { "setitem", m_setitem },
-        { "size", m_size },
-        { "resize", m_resize },
-        { "iter", m_iter },
-        { NULL, NULL }
+        { ".data", NULL, NULL },
+        { "init", m_init, NULL },
+        { "tostring", m_tostring, NULL },
+        { "append", NULL, m_append },
+        { "insert", m_insert, NULL },
+        { "remove", m_remove, NULL },
+        { "item", NULL, m_item },
+        { "setitem", NULL, m_setitem },
+        { "size", NULL, m_size },
+        { "resize", m_resize, NULL },
+        { "iter", m_iter, NULL },
+        { NULL, NULL, NULL }
     };
     be_regclass(vm, "list", members);
 }
@@ -279,12 +312,12 @@ class be_class_list (scope: global, name: list) {
     .data, var
     init, func(m_init)
     tostring, func(m_tostring)
-    append, func(m_append)
+    append, lfunc(m_append)
     insert, func(m_insert)
     remove, func(m_remove)
-    item, func(m_item)
-    setitem, func(m_setitem)
-    size, func(m_size)
+    item, lfunc(m_item)
+    setitem, lfunc(m_setitem)
+    size, lfunc(m_size)
     resize, func(m_resize)
     iter, func(m_iter)
 }
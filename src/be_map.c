@@ -11,13 +11,19 @@
 #define isnil(node)         var_isnil(key(node))
 #define setnil(node)        var_setnil(key(node))
 #define hash2slot(m, h)     ((m)->slots + (h) % (m)->size)
-#define hashcode(_v)        _hashcode_((_v)->type, (_v)->v)
 
 #define next(node)          ((node)->key.next)
 #define pos2slot(map, n)    ((n) != LASTNODE ? ((map)->slots + (n)) : NULL)
 #define pos(map, node)      ((uint16_t)((node) - (map)->slots))
+#if BE_USE_NAN_BOXING
+#define setkey(node, _v)    ((node)->key.v = (_v)->v)
+#define getkey(_v, node)    ((_v)->v = (node)->key.v)
+#else
 #define setkey(node, _v)    { (node)->key.type = (bbyte)(_v)->type; \
                               (node)->key.v = (_v)->v; }
+#define getkey(_v, node)    { (_v)->type = (node)->key.type; \
+                              (_v)->v = (node)->key.v; }
+#endif
 
 #define datasize(size)      ((size) * sizeof(bmapnode))
 
@@ -38,41 +44,48 @@ uint32_t hashptr(void *p)
     return (uint32_t)((i ^ (i >> 16)) & 0xFFFFFFFF);
 }
 
-static uint32_t _hashcode_(int type, union bvaldata v)
+static uint32_t hashcode(bvalue *key)
 {
-    switch (type) {
+    switch (var_type(key)) {
     case BE_NIL:
         return 0;
     case BE_BOOL:
-        return (uint32_t)v.b;
+        return (uint32_t)var_tobool(key);
     case BE_INT:
-        return (uint32_t)v.i;
+        return (uint32_t)var_toint(key);
     case BE_REAL:
-        return (uint32_t)v.i; /* test */
+        return (uint32_t)var_toint(key); /* test */
     case BE_STRING:
-        return be_strhash(v.s);
+        return be_strhash(var_tostr(key));
     default:
-        return hashptr(v.p);
+        return hashptr(var_toobj(key));
     }
 }
 
+static uint32_t hashkey(bmapnode *node)
+{
+    bvalue v;
+    getkey(&v, node);
+    return hashcode(&v);
+}
+
 static int eqnode(bmapnode *node, bvalue *key, uint32_t hash)
 {
     bmapkey *k = key(node);
-    if (hashcode(key(node)) == hash && (int)k->type == key->type) {
-        switch (key->type) {
+    if (hashkey(node) == hash && var_type(k) == var_type(key)) {
+        switch (var_type(key)) {
         case BE_NIL:
             return 0;
         case BE_BOOL:
-            return key->v.b == k->v.b;
+            return var_tobool(key) == var_tobool(k);
         case BE_INT:
-            return key->v.b == k->v.b;
+            return var_toint(key) == var_toint(k);
         case BE_REAL:
-            return key->v.r == k->v.r;
+            return var_toreal(key) == var_toreal(k);
         case BE_STRING:
-            return be_eqstr(key->v.s, k->v.s);
+            return be_eqstr(var_tostr(key), var_tostr(k));
         default:
-            return key->v.p == k->v.p;
+            return var_toobj(key) == var_toobj(k);
         }
     }
     return 0;
@@ -111,7 +124,7 @@ static bmapnode* insert(bmap *map, bvalue *key, uint32_t hash)
         setkey(slot, key);
         next(slot) = LASTNODE;
     } else {
-        uint32_t h = hashcode(key(slot)); /* get the hashcode of the exist node */
+        uint32_t h = hashkey(slot); /* get the hashcode of the exist node */
         bmapnode *mainslot = hash2slot(map, h); /* get the main-slot */
         bmapnode *new = nextfree(map); /* get a free slot */
         if (mainslot == slot) { /* old is main slot */
@@ -169,8 +182,7 @@ static void resize(bvm *vm, bmap *map, int size)
         if (!isnil(node)) {
             bvalue v;
             bmapnode *newslot;
-            v.type = node->key.type;
-            v.v = node->key.v;
+            getkey(&v, node);
             newslot = insert(map, &v, hashcode(&v));
             newslot->value = node->value;
         }
@@ -200,6 +212,13 @@ void be_map_delete(bvm *vm, bmap *map)
     be_free(vm, map, sizeof(bmap));
 }
 
+void be_map_reserve(bvm *vm, bmap *map, int count)
+{
+    if (count > map->size) {
+        resize(vm, map, map_nextsize(count));
+    }
+}
+
 bvalue* be_map_find(bmap *map, bvalue *key)
 {
     bmapnode *entry = find(map, key, hashcode(key));
@@ -215,8 +234,10 @@ bvalue* be_map_insert(bvm *vm, bmap *map, bvalue *key, bvalue *value)
             resize(vm, map, map_nextsize(map->size));
         }
         entry = insert(map, key, hash);
+        var_setnil(value(entry)); /* the GC may scan it before it is set */
         ++map->count;
     }
+    be_gc_barrier(vm, map);
     if (value) {
         entry->value = *value;
     }
@@ -294,8 +315,7 @@ bmapnode* be_map_next(bmap *map, bmapiter *iter)
 bvalue be_map_key2value(bmapnode *node)
 {
     bvalue v;
-    v.type = node->key.type;
-    v.v = node->key.v;
+    getkey(&v, node);
     return v;
 }
 
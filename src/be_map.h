@@ -3,11 +3,18 @@
 
 #include "be_object.h"
 
+#if BE_USE_NAN_BOXING
+typedef struct bmapkey {
+    union bvaldata v;
+    uint32_t next;
+} bmapkey;
+#else
 typedef struct bmapkey {
     union bvaldata v;
     uint32_t type:8;
     uint32_t next:24;
 } bmapkey;
+#endif
 
 typedef struct bmapnode {
     bmapkey key;
@@ -31,6 +38,7 @@ typedef bmapnode *bmapiter;
 
 bmap* be_map_new(bvm *vm);
 void be_map_delete(bvm *vm, bmap *map);
+void be_map_reserve(bvm *vm, bmap *map, int count);
 bvalue* be_map_find(bmap *map, bvalue *key);
 bvalue* be_map_insert(bvm *vm, bmap *map, bvalue *key, bvalue *value);
 int be_map_remove(bmap *map, bvalue *key);
@@ -1,4 +1,8 @@
 #include "be_object.h"
+#include "be_class.h"
+#include "be_map.h"
+#include "be_vm.h"
+#include "be_gc.h"
 
 #define map_check_data(vm, argc)                        \
     if (!be_ismap(vm, -1) || be_top(vm) - 1 < argc) {   \
@@ -11,6 +15,23 @@
         be_return(vm);                                  \
     }
 
+/* the map data of the instance argv[0], or NULL when there are less
+ * than n arguments. the light methods read the arguments from argv and
+ * store the result in argv[-1]. */
+static bmap* map_data(bvm *vm, bvalue *argv, int argc, int n)
+{
+    if (argc >= n && var_isinstance(argv)) {
+        binstance *obj = var_toobj(argv);
+        while (obj && obj->class != vm->mapclass) { /* derived instances */
+            obj = obj->super;
+        }
+        if (obj && var_ismap(be_instance_members(obj))) {
+            return var_toobj(be_instance_members(obj));
+        }
+    }
+    return NULL;
+}
+
 static int m_init(bvm *vm)
 {
     if (be_top(vm) > 1 && be_ismap(vm, 2)) {
@@ -95,31 +116,39 @@ static int m_remove(bvm *vm)
     be_return_nil(vm);
 }
 
-static int m_item(bvm *vm)
+static int m_item(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    map_check_data(vm, 2);
-    be_pushvalue(vm, 2);
-    be_getindex(vm, -2);
-    be_return(vm);
+    bmap *map = map_data(vm, argv, argc, 2);
+    bvalue *v = map && !var_isnil(argv + 1) ? be_map_find(map, argv + 1) : NULL;
+    if (v) {
+        var_setval(argv - 1, v);
+    } else {
+        var_setnil(argv - 1);
+    }
+    return 0;
 }
 
-static int m_setitem(bvm *vm)
+static int m_setitem(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    map_check_data(vm, 3);
-    be_pushvalue(vm, 2);
-    be_pushvalue(vm, 3);
-    be_setindex(vm, -3);
-    be_return_nil(vm);
+    bmap *map = map_data(vm, argv, argc, 3);
+    bvalue *dst = map && !var_isnil(argv + 1) ? be_map_find(map, argv + 1) : NULL;
+    if (dst) {
+        be_gc_barrier(vm, map);
+        var_setval(dst, argv + 2);
+    }
+    var_setnil(argv - 1);
+    return 0;
 }
 
-static int m_size(bvm *vm)
+static int m_size(bvm *vm, bvalue *argv, int argc)
 {
-    be_getmember(vm, 1, ".data");
-    map_check_data(vm, 1);
-    be_pushint(vm, be_data_size(vm, -1));
-    be_return(vm);
+    bmap *map = map_data(vm, argv, argc, 1);
+    if (map) {
+        var_setint(argv - 1, be_map_count(map));
+    } else {
+        var_setnil(argv - 1);
+    }
+    return 0;
 }
 
 static int i_init(bvm *vm)
@@ -157,12 +186,12 @@ static int i_next(bvm *vm)
 static int m_iter(bvm *vm)
 {
     static const bnfuncinfo members[] = {
-        { ".obj", NULL },
-        { ".iter", NULL },
-        { "init", i_init },
-        { "hasnext", i_hashnext },
-        { "next", i_next },
-        { NULL, NULL }
+        { ".obj", NULL, NULL },
+        { ".iter", NULL, NULL },
+        { "init", i_init, NULL },
+        { "hasnext", i_hashnext, NULL },
+        { "next", i_next, NULL },
+        { NULL, NULL, NULL }
     };
     be_pushclass(vm, "iterator", members);
     be_pushvalue(vm, 1);
@@ -175,16 +204,16 @@ static int m_iter(bvm *vm)
 void be_load_maplib(bvm *vm)
 {
     static const bnfuncinfo members[] = {
-        { ".data", NULL },
-        { "init", m_init },
-        { "tostring", m_tostring },
-        { "insert", m_insert },
-        { "remove", m_remove },
-        { "item", m_item },
-        { "setitem", m_setitem },
-        { "size", m_size },
-        { "iter", m_iter },
-        { NULL, NULL }
+        { ".data", NULL, NULL },
+        { "init", m_init, NULL },
+        { "tostring", m_tostring, NULL },
+        { "insert", m_insert, NULL },
+        { "remove", m_remove, NULL },
+        { "item", NULL, m_item },
+        { "setitem", NULL, m_setitem },
+        { "size", NULL, m_size },
+        { "iter", m_iter, NULL },
+        { NULL, NULL, NULL }
     };
     be_regclass(vm, "map", members);
 }
@@ -196,9 +225,9 @@ class be_class_map (scope: global, name: map) {
     tostring, func(m_tostring)
     insert, func(m_insert)
     remove, func(m_remove)
-    item, func(m_item)
-    setitem, func(m_setitem)
-    size, func(m_size)
+    item, lfunc(m_item)
+    setitem, lfunc(m_setitem)
+    size, lfunc(m_size)
     iter, func(m_iter)
 }
 @const_object_info_end */
@@ -3,9 +3,21 @@
 #include "be_vm.h"
 #include "be_gc.h"
 #include <stdlib.h>
+#include <string.h>
 
 #define GC_ALLOC    (1 << 2) /* GC in alloc */
 
+#if BE_USE_MEM_POOL && (BE_MEM_SLAB_SIZE < MEM_POOL_MAX * 4 || \
+    (BE_MEM_SLAB_SIZE & (BE_MEM_SLAB_SIZE - 1)))
+  #error "BE_MEM_SLAB_SIZE must be a power of 2 and at least 1024."
+#endif
+
+#define MEM_CHUNK_SLABS     16 /* the count of the slabs in a chunk */
+
+#define pool_index(size)    (((size) - 1) / MEM_POOL_ALIGN)
+#define pool_small(size)    ((size) && (size) <= MEM_POOL_MAX)
+#define pool_next(block)    (*(void**)(block))
+
 #ifdef BE_EXPLICIT_MALLOC
   #define malloc                BE_EXPLICIT_MALLOC
 #endif
@@ -33,11 +45,270 @@ void* be_os_realloc(void *ptr, size_t size)
     return realloc(ptr, size);
 }
 
-static void* _realloc(void *ptr, size_t old_size, size_t new_size)
+#if BE_USE_MEM_POOL
+/* a slab of BE_MEM_SLAB_SIZE bytes is aligned on its size, so the slab of
+ * a block is found from the block address. the slabs are allocated in
+ * chunks, and a chunk is freed when all of its slabs are empty */
+typedef struct bchunk {
+    struct bchunk *prev, *next; /* the chunk list of the pool */
+    void *raw; /* the memory allocated by the system */
+    bslab *base; /* the first slab of the chunk */
+    int nempty; /* the count of the empty slabs */
+} bchunk;
+
+#define header_size(T) \
+    ((sizeof(T) + MEM_POOL_ALIGN - 1) & ~(size_t)(MEM_POOL_ALIGN - 1))
+#define SLAB_HEADER     header_size(bslab)
+#define PAGE_HEADER     header_size(bgcpage)
+#define block2slab(b)   cast(bslab*, (uintptr_t)(b) & ~(uintptr_t)(BE_MEM_SLAB_SIZE - 1))
+#define slab_at(base, i) cast(bslab*, cast(char*, base) + (size_t)(i) * BE_MEM_SLAB_SIZE)
+
+static void slab_link(bslab **list, bslab *slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+static void slab_unlink(bslab **list, bslab *slab)
+{
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+/* allocate a chunk of the slabs, and add them to the empty slab list */
+static int new_chunk(struct bmempool *pool)
+{
+    size_t size = (size_t)MEM_CHUNK_SLABS * BE_MEM_SLAB_SIZE;
+    char *raw = malloc(size + BE_MEM_SLAB_SIZE), *base;
+    bchunk *chunk;
+    int i;
+    if (raw == NULL) {
+        return 0;
+    }
+    base = cast(char*, slab_at(block2slab(raw), 1));
+    if (base - raw >= BE_MEM_SLAB_SIZE) {
+        base = raw; /* aligned by the system */
+    }
+    /* the chunk header is placed in the space out of the slabs */
+    chunk = cast(bchunk*,
+        base - raw >= (ptrdiff_t)sizeof(bchunk) ? raw : base + size);
+    chunk->raw = raw;
+    chunk->base = cast(bslab*, base);
+    chunk->nempty = MEM_CHUNK_SLABS;
+    chunk->prev = NULL;
+    chunk->next = pool->chunks;
+    if (pool->chunks) {
+        pool->chunks->prev = chunk;
+    }
+    pool->chunks = chunk;
+    for (i = 0; i < MEM_CHUNK_SLABS; ++i) {
+        bslab *slab = slab_at(base, i);
+        slab->chunk = chunk;
+        slab_link(&pool->empty, slab);
+    }
+    pool->nempty += MEM_CHUNK_SLABS;
+    return 1;
+}
+
+/* free the chunk when all of its slabs are empty, a chunk of the empty
+ * slabs is always kept to avoid allocating chunks repeatedly */
+static void free_chunk(struct bmempool *pool, bchunk *chunk)
+{
+    int i;
+    if (chunk->nempty < MEM_CHUNK_SLABS || pool->nempty < MEM_CHUNK_SLABS * 2) {
+        return;
+    }
+    for (i = 0; i < MEM_CHUNK_SLABS; ++i) {
+        slab_unlink(&pool->empty, slab_at(chunk->base, i));
+    }
+    pool->nempty -= MEM_CHUNK_SLABS;
+    if (chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        pool->chunks = chunk->next;
+    }
+    if (chunk->next) {
+        chunk->next->prev = chunk->prev;
+    }
+    free(chunk->raw);
+}
+
+/* take an empty slab and divide it into the free blocks of the class,
+ * the blocks follow the header of the slab */
+static bslab* new_slab(struct bmempool *pool, bslab **partial,
+    int index, int ispage)
+{
+    size_t size = (size_t)(index + 1) * MEM_POOL_ALIGN;
+    size_t header = ispage ? PAGE_HEADER : SLAB_HEADER;
+    bslab *slab;
+    char *block, *end;
+    if (pool->empty == NULL && !new_chunk(pool)) {
+        return NULL;
+    }
+    slab = pool->empty;
+    slab_unlink(&pool->empty, slab);
+    slab->chunk->nempty--;
+    pool->nempty--;
+    pool->nslabs[index]++;
+    slab->index = index;
+    slab->nused = 0;
+    slab->ispage = ispage;
+    slab->free = NULL;
+    block = cast(char*, slab) + header;
+    end = block + (BE_MEM_SLAB_SIZE - header) / size * size;
+    while (end > block) { /* the blocks are allocated in address order */
+        end -= size;
+        pool_next(end) = slab->free;
+        slab->free = end;
+    }
+    slab_link(partial, slab);
+    return slab;
+}
+
+/* return an empty slab to the empty slab list */
+static void release_slab(struct bmempool *pool, bslab **partial, bslab *slab)
+{
+    slab_unlink(partial, slab);
+    slab_link(&pool->empty, slab);
+    pool->nslabs[slab->index]--;
+    pool->nempty++;
+    slab->chunk->nempty++;
+    free_chunk(pool, slab->chunk);
+}
+
+static void* slab_alloc(struct bmempool *pool, bslab **partial, bslab *slab)
+{
+    void *block = slab->free;
+    slab->free = pool_next(block);
+    slab->nused++;
+    if (slab->free == NULL) { /* the slab is full */
+        slab_unlink(partial, slab);
+    }
+    pool->nused[slab->index]++;
+    return block;
+}
+
+static void* pool_alloc(struct bmempool *pool, size_t size)
+{
+    int index = pool_index(size);
+    bslab *slab = pool->partial[index];
+    if (slab == NULL && (slab = new_slab(pool,
+            &pool->partial[index], index, 0)) == NULL) {
+        return NULL;
+    }
+    return slab_alloc(pool, &pool->partial[index], slab);
+}
+
+static void pool_free(struct bmempool *pool, void *block, size_t size)
+{
+    int index = pool_index(size);
+    bslab *slab = block2slab(block);
+    bslab **partial = slab->ispage ?
+        &pool->gcpartial[index] : &pool->partial[index];
+    be_assert(slab->index == index);
+    if (slab->free == NULL) { /* the slab was full */
+        slab_link(partial, slab);
+    }
+    pool_next(block) = slab->free;
+    slab->free = block;
+    pool->nused[index]--;
+    --slab->nused;
+    if (slab->ispage) { /* the GC pages are released by the sweep */
+        bgcpage *page = cast(bgcpage*, slab);
+        int bit = be_gcpage_bit(block);
+        be_bitmap_clear(page->alloc, bit);
+        be_bitmap_clear(page->mark, bit);
+        be_bitmap_clear(page->old, bit);
+    } else if (slab->nused == 0 && (slab->prev || slab->next)) {
+        release_slab(pool, partial, slab); /* the last one of the class is kept */
+    }
+}
+
+/* allocate an object in the GC pages, a new page has no marks and it is
+ * not swept by the running sweep */
+static void* page_alloc(bvm *vm, size_t size)
+{
+    struct bmempool *pool = &vm->pool;
+    int index = pool_index(size);
+    bslab *slab = pool->gcpartial[index];
+    bgcpage *page;
+    void *block;
+    if (slab == NULL) {
+        slab = new_slab(pool, &pool->gcpartial[index], index, 1);
+        if (slab == NULL) {
+            return NULL;
+        }
+        page = cast(bgcpage*, slab);
+        memset(page->alloc, 0, sizeof(page->alloc));
+        memset(page->mark, 0, sizeof(page->mark));
+        memset(page->old, 0, sizeof(page->old));
+        page->sweepid = vm->gc.sweepid;
+        page->young = 0;
+        page->prev = NULL;
+        page->next = pool->gcpages;
+        if (pool->gcpages) {
+            pool->gcpages->prev = page;
+        }
+        pool->gcpages = page;
+    }
+    block = slab_alloc(pool, &pool->gcpartial[index], slab);
+    be_bitmap_set(cast(bgcpage*, slab)->alloc, be_gcpage_bit(block));
+    return block;
+}
+
+/* reallocate a block of which the old or the new size is small, the
+ * block is copied when it moves between the size classes */
+static void* pool_realloc(struct bmempool *pool,
+    void *ptr, size_t old_size, size_t new_size)
+{
+    void *block = NULL;
+    if (pool_small(old_size) && pool_small(new_size)
+            && pool_index(old_size) == pool_index(new_size)) {
+        return ptr; /* in the same size class */
+    }
+    if (new_size) {
+        block = pool_small(new_size) ?
+            pool_alloc(pool, new_size) : malloc(new_size);
+        if (block == NULL) {
+            return NULL; /* the old block is kept */
+        }
+        if (ptr) {
+            memcpy(block, ptr, old_size < new_size ? old_size : new_size);
+        }
+    }
+    if (ptr) {
+        if (pool_small(old_size)) {
+            pool_free(pool, ptr, old_size);
+        } else {
+            free(ptr);
+        }
+    }
+    return block;
+}
+#endif
+
+static void* _realloc(bvm *vm, void *ptr, size_t old_size, size_t new_size)
 {
     if (old_size == new_size) { /* the block unchanged */
         return ptr;
     }
+#if BE_USE_MEM_POOL
+    if (pool_small(old_size) || pool_small(new_size)) {
+        return pool_realloc(&vm->pool, ptr, old_size, new_size);
+    }
+#else
+    (void)vm;
+#endif
     if (ptr && new_size) { /* realloc block */
         return realloc(ptr, new_size);
     }
@@ -50,14 +321,20 @@ static void* _realloc(void *ptr, size_t old_size, size_t new_size)
     return NULL;
 }
 
+/* collect the garbage when the allocation fails */
+static void alloc_fail(bvm *vm)
+{
+    vm->gc.status |= GC_ALLOC;
+    be_gc_collect(vm); /* try to allocate again after GC */
+    vm->gc.status &= ~GC_ALLOC;
+}
+
 void* be_realloc(bvm *vm, void *ptr, size_t old_size, size_t new_size)
 {
-    void *block = _realloc(ptr, old_size, new_size);
+    void *block = _realloc(vm, ptr, old_size, new_size);
     if (!block && new_size) { /* allocation failure */
-        vm->gc.status |= GC_ALLOC;
-        be_gc_collect(vm); /* try to allocate again after GC */
-        vm->gc.status &= ~GC_ALLOC;
-        block = _realloc(ptr, old_size, new_size);
+        alloc_fail(vm);
+        block = _realloc(vm, ptr, old_size, new_size);
         if (!block) { /* lack of heap space */
             be_throw(vm, BE_MALLOC_FAIL);
         }
@@ -70,3 +347,98 @@ size_t be_memcount(bvm *vm)
 {
     return vm->gc.usage;
 }
+
+void be_mempool_init(bvm *vm)
+{
+#if BE_USE_MEM_POOL
+    memset(&vm->pool, 0, sizeof(struct bmempool));
+#else
+    (void)vm;
+#endif
+}
+
+/* free all chunks, the blocks still in use are freed as well */
+void be_mempool_delete(bvm *vm)
+{
+#if BE_USE_MEM_POOL
+    bchunk *chunk = vm->pool.chunks;
+    while (chunk) {
+        bchunk *next = chunk->next;
+        free(chunk->raw);
+        chunk = next;
+    }
+    vm->pool.chunks = NULL;
+    vm->pool.gcpages = NULL;
+#else
+    (void)vm;
+#endif
+}
+
+/* allocate a GC object of up to MEM_POOL_MAX bytes in the GC pages, the
+ * result is NULL for the larger objects, see be_newgcobj() */
+void* be_mempool_gcalloc(bvm *vm, size_t size)
+{
+#if BE_USE_MEM_POOL
+    if (pool_small(size)) {
+        void *block = page_alloc(vm, size);
+        if (block == NULL) {
+            alloc_fail(vm);
+            block = page_alloc(vm, size);
+            if (block == NULL) {
+                be_throw(vm, BE_MALLOC_FAIL);
+            }
+        }
+        vm->gc.usage += size;
+        return block;
+    }
+#else
+    (void)vm; (void)size;
+#endif
+    return NULL;
+}
+
+/* release a GC page if all of its objects are freed */
+void be_mempool_gcrelease(bvm *vm, bgcpage *page)
+{
+#if BE_USE_MEM_POOL
+    struct bmempool *pool = &vm->pool;
+    bslab *slab = &page->slab;
+    if (slab->nused == 0) {
+        if (page->prev) {
+            page->prev->next = page->next;
+        } else {
+            pool->gcpages = page->next;
+        }
+        if (page->next) {
+            page->next->prev = page->prev;
+        }
+        release_slab(pool, &pool->gcpartial[slab->index], slab);
+    }
+#else
+    (void)vm; (void)page;
+#endif
+}
+
+/* get the total size of the slabs and the size of the blocks in use, the
+ * difference is the free space of the pool */
+void be_mempool_stat(bvm *vm, size_t *slabsize, size_t *usedsize)
+{
+    size_t slabs = 0, used = 0;
+#if BE_USE_MEM_POOL
+    int i;
+    slabs = vm->pool.nempty;
+    for (i = 0; i < MEM_POOL_CLASSES; ++i) {
+        slabs += vm->pool.nslabs[i];
+        used += vm->pool.nused[i] * (size_t)(i + 1) * MEM_POOL_ALIGN;
+    }
+    slabs *= BE_MEM_SLAB_SIZE;
+#else
+    (void)vm;
+#endif
+    if (slabsize) {
+        *slabsize = slabs;
+    }
+    if (usedsize) {
+        *usedsize = used;
+    }
+}
@@ -6,10 +6,64 @@
 #define be_malloc(vm, size)         be_realloc((vm), NULL, 0, (size))
 #define be_free(vm, ptr, size)      be_realloc((vm), (ptr), (size), 0)
 
+#define MEM_POOL_ALIGN              8 /* the step of the size classes */
+#define MEM_POOL_MAX                256 /* the largest block in the pool */
+#define MEM_POOL_CLASSES            (MEM_POOL_MAX / MEM_POOL_ALIGN)
+/* the words of a bitmap with a bit for each MEM_POOL_ALIGN bytes of a page */
+#define MEM_PAGE_WORDS              (BE_MEM_SLAB_SIZE / MEM_POOL_ALIGN / 32)
+
+/* the header of a slab, the slabs are aligned on their size */
+typedef struct bslab {
+    struct bslab *prev, *next; /* the partial or the empty slab list */
+    struct bchunk *chunk; /* the chunk of the slab */
+    void *free; /* the free blocks of the slab */
+    int index; /* the size class */
+    int nused; /* the count of the blocks in use */
+    int ispage; /* the blocks are GC objects, see bgcpage */
+} bslab;
+
+/* a slab of the small GC objects. the objects are not linked in a list,
+ * the sweep walks the pages and finds the objects in the bitmaps, where
+ * the bit of an object is the one of its first MEM_POOL_ALIGN bytes */
+typedef struct bgcpage {
+    bslab slab;
+    struct bgcpage *prev, *next; /* the list of the GC pages */
+    bbyte sweepid; /* the id of the last sweep of the page */
+    bbyte young; /* the page is in the set of the young pages */
+    uint32_t alloc[MEM_PAGE_WORDS]; /* the objects allocated */
+    uint32_t mark[MEM_PAGE_WORDS]; /* the objects reached by the marking */
+    uint32_t old[MEM_PAGE_WORDS]; /* the old objects in the generational mode */
+} bgcpage;
+
+#define be_gcpage(o) \
+    ((bgcpage*)((uintptr_t)(o) & ~(uintptr_t)(BE_MEM_SLAB_SIZE - 1)))
+#define be_gcpage_bit(o) \
+    ((int)(((uintptr_t)(o) & (BE_MEM_SLAB_SIZE - 1)) / MEM_POOL_ALIGN))
+#define be_bitmap_test(map, i)      (((map)[(i) >> 5] >> ((i) & 31)) & 1)
+#define be_bitmap_set(map, i)       ((map)[(i) >> 5] |= (uint32_t)1 << ((i) & 31))
+#define be_bitmap_clear(map, i)     ((map)[(i) >> 5] &= ~((uint32_t)1 << ((i) & 31)))
+
+/* the memory pool of a VM, the blocks of a size class are allocated from
+ * the slabs of that class. the empty slabs are shared by all classes */
+struct bmempool {
+    struct bslab *partial[MEM_POOL_CLASSES]; /* the slabs having free blocks */
+    struct bslab *gcpartial[MEM_POOL_CLASSES]; /* the GC pages having free blocks */
+    struct bgcpage *gcpages; /* all GC pages, the new ones are at the head */
+    struct bslab *empty; /* the empty slabs */
+    struct bchunk *chunks; /* the chunks of the slabs */
+    size_t nslabs[MEM_POOL_CLASSES]; /* the slab count of each class */
+    size_t nused[MEM_POOL_CLASSES]; /* the blocks in use of each class */
+    size_t nempty; /* the count of the empty slabs */
+};
+
 void* be_os_malloc(size_t size);
 void be_os_free(void *ptr);
 void* be_os_realloc(void *ptr, size_t size);
 void* be_realloc(bvm *vm, void *ptr, size_t old_size, size_t new_size);
 size_t be_memcount(bvm *vm);
+void be_mempool_init(bvm *vm);
+void be_mempool_delete(bvm *vm);
+void* be_mempool_gcalloc(bvm *vm, size_t size);
+void be_mempool_gcrelease(bvm *vm, bgcpage *page);
 
 #endif
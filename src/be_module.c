@@ -25,7 +25,8 @@ static bntvmodule* find_native(bstring *path)
 static bmodule* find_existed(bvm *vm, bntvmodule *nm)
 {
     bmodule *node  = vm->modulelist;
-    while (node && node->info.native != nm) {
+    /* the unreachable modules which are not yet swept are skipped */
+    while (node && (node->info.native != nm || gc_isdead(vm, node))) {
         node = node->mnext;
     }
     return node;
@@ -38,7 +39,7 @@ static void insert_attrs(bvm *vm, bmap *table, bntvmodule *nm)
         bntvmodule_obj *node = nm->table + i;
         bstring *name = be_newstr(vm, node->name);
         bvalue *v = be_map_insertstr(vm, table, name, NULL);
-        be_assert(node->type <= BE_CMODULE);
+        be_assert(node->type <= BE_CLFUNCTION);
         switch (node->type) {
         case BE_CNIL:
             var_setnil(v);
@@ -55,6 +56,9 @@ static void insert_attrs(bvm *vm, bmap *table, bntvmodule *nm)
         case BE_CFUNCTION:
             var_setntvfunc(v, node->u.f);
             break;
+        case BE_CLFUNCTION:
+            var_setlntvfunc(v, node->u.lf);
+            break;
         case BE_CSTRING:
             var_setstr(v, be_newstr(vm, node->u.s));
             break;
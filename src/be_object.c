@@ -1,5 +1,14 @@
 #include "be_object.h"
 
+#if BE_USE_NAN_BOXING
+/* the value type of each NaN-boxing tag */
+const signed char be_nanbox_types[16] = {
+    BE_NIL, BE_INT, BE_NONE, BE_BOOL, BE_LNTVFUNC, BE_STRING, BE_CLASS,
+    BE_INSTANCE, BE_PROTO, BE_LIST, BE_MAP, BE_MODULE, BE_CLOSURE,
+    BE_NTVCLOS, BE_COMPTR, BE_NONE
+};
+#endif
+
 const char* be_vtype2str(bvalue *v)
 {
     switch(var_type(v)) {
@@ -8,7 +17,7 @@ const char* be_vtype2str(bvalue *v)
     case BE_REAL: return "real";
     case BE_BOOL: return "bool";
     case BE_CLOSURE: case BE_NTVCLOS:
-    case BE_NTVFUNC: return "function";
+    case BE_NTVFUNC: case BE_LNTVFUNC: return "function";
     case BE_PROTO: return "proto";
     case BE_CLASS: return "class";
     case BE_STRING: return "string";
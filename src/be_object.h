@@ -21,11 +21,13 @@
 #define BE_NTVFUNC      ((0 << 5) | BE_FUNCTION)
 #define BE_CLOSURE      ((1 << 5) | BE_FUNCTION)
 #define BE_NTVCLOS      ((2 << 5) | BE_FUNCTION)
+#define BE_LNTVFUNC     ((3 << 5) | BE_FUNCTION)
 
 #define array_count(a)   (sizeof(a) / sizeof((a)[0]))
 
+/* the GC objects are not linked, they are found in the GC pages or in
+ * the object set of the GC (see struct bgc) */
 #define bcommon_header          \
-    struct bgcobject *next;     \
     bbyte type;                 \
     bbyte marked
 
@@ -62,6 +64,37 @@ typedef struct bvector {
                        the end pointer will be smaller than the data pointer */
 } bvector, bstack;
 
+#if BE_USE_JIT && !(defined(__x86_64__) && defined(__linux__))
+  #undef BE_USE_JIT /* the JIT compiler only generates x86-64 code */
+  #define BE_USE_JIT            0
+#endif
+
+#if BE_USE_JIT && (BE_USE_NAN_BOXING || BE_SINGLE_FLOAT != 0 || BE_INTGER_TYPE != 2)
+#error "BE_USE_JIT requires unboxed values, double reals and long long integers."
+#endif
+
+#if BE_USE_NAN_BOXING
+#if BE_SINGLE_FLOAT != 0 || BE_INTGER_TYPE != 0 || UINTPTR_MAX != UINT64_MAX
+#error "BE_USE_NAN_BOXING is a 32-bit integer mode, it requires BE_INTGER_TYPE 0, double reals and 64-bit pointers."
+#endif
+
+/* NaN-boxed value data. real numbers are stored as is, other values
+ * use the NaN space: 0xFFF8 | tag (4 bits) | payload (47 bits). native
+ * functions are stored as raw pointers below 2^48, so the positive
+ * subnormals are flushed to 0 and the NaNs in the boxed space become
+ * the canonical NaN, see BE_USE_NAN_BOXING in berry_conf.h */
+union bvaldata {
+    uint64_t u;     /* the boxed bits */
+    breal r;        /* real number */
+    bntvfunc nf;    /* native C function */
+    blntvfunc lf;   /* light native C function */
+    char *p;        /* tagged object pointer (constant objects only) */
+};
+
+typedef struct bvalue {
+    union bvaldata v; /* the boxed type and value */
+} bvalue;
+#else
 /* berry value data union, a berry value is always described
  * by the data structure contained in the bvaldata union. */
 union bvaldata {
@@ -72,6 +105,7 @@ union bvaldata {
     bstring *s;     /* string pointer */
     bgcobject *gc;  /* GC object */
     bntvfunc nf;    /* native C function */
+    blntvfunc lf;   /* light native C function */
 };
 
 /* berry value. for simple types, the value of the data is stored,
@@ -80,6 +114,7 @@ typedef struct bvalue {
     union bvaldata v; /* the value data */
     int type;         /* the value type */
 } bvalue;
+#endif
 
 typedef struct {
     bstring *name; /* the name of variable */
@@ -108,14 +143,19 @@ typedef struct {
 } blineinfo;
 
 typedef struct bupval {
-    bvalue *value;
-    union {
-        bvalue value;
-        struct bupval *next;
-    } u;
+    bvalue *value; /* the stack slot, or 'closed' after closing */
+    bvalue closed;
     int refcnt;
 } bupval;
 
+/* inline cache of the member access instructions */
+typedef struct {
+    bgcobject *owner; /* the class or module of the last lookup */
+    bvalue value; /* member variable index, method or module attribute */
+    int depth; /* inheritance depth of the class owning the variable */
+    unsigned int version; /* the class chain version when it was filled */
+} bmcache;
+
 typedef struct bproto {
     bcommon_header;
     bbyte nlocal; /* local variable count */
@@ -127,10 +167,16 @@ typedef struct bproto {
     bvalue *ktab; /* constants table */
     struct bproto **ptab; /* proto table */
     binstruction *code; /* instructions sequence */
+    bmcache *mcache; /* member caches (indexed by instruction) */
+    bclosure *closure; /* shared closure if there are no upvalues */
     bstring *name; /* function name */
     int codesize; /* code size */
     int nconst; /* constants count */
     int nproto; /* proto count */
+#if BE_USE_JIT
+    struct bjitcode *jit; /* native code, NULL until the function is hot */
+    unsigned int hotness; /* count of the entries and loop back edges */
+#endif
 #if BE_DEBUG_RUNTIME_INFO /* debug information */
     bstring *source;
     blineinfo *lineinfo;
@@ -161,6 +207,67 @@ typedef const char* (*breader)(void*, size_t*);
 #define cast_bool(_v)           cast(bbool, _v)
 #define basetype(_t)            ((_t) & 0x1F)
 
+#if BE_USE_NAN_BOXING
+#define NANBOX_BASE             0xFFF8000000000000ULL
+#define NANBOX_NAN              0x7FF8000000000000ULL
+#define NANBOX_PAYLOAD          0x00007FFFFFFFFFFFULL
+#define NANBOX_FUNCMAX          0x0000FFFFFFFFFFFFULL
+
+/* the tag of the types that are not encoded by their own value */
+#define nanbox_tag(_t)          ((_t) == BE_CLOSURE ? 12 : (_t) == BE_NTVCLOS ? 13 : \
+                                 (_t) == BE_COMPTR ? 14 : (_t) == BE_NONE ? 15 : \
+                                 (_t) == BE_LNTVFUNC ? 4 : (_t))
+#define nanbox_bits(_t)         (NANBOX_BASE | ((uint64_t)nanbox_tag(_t) << 47))
+#define nanbox_isboxed(_v)      ((_v)->v.u >= NANBOX_BASE)
+#define nanbox_isfunc(_v)       ((_v)->v.u - 1 < NANBOX_FUNCMAX)
+
+#define var_type(_v)            (nanbox_isboxed(_v) ? be_nanbox_types[((_v)->v.u >> 47) & 0x0F] : \
+                                 nanbox_isfunc(_v) ? BE_NTVFUNC : BE_REAL)
+#define var_basetype(_v)        basetype(var_type(_v))
+#define var_istype(_v, _t)      (var_type(_v) == _t)
+#define var_hastag(_v, _t)      ((_v)->v.u >> 47 == nanbox_bits(_t) >> 47)
+#define var_settype(_v, _t)     ((_v)->v.u = ((_v)->v.u & NANBOX_PAYLOAD) | nanbox_bits(_t))
+#define var_setobj(_v, _t, _o)  { (_v)->v.u = nanbox_bits(_t) | (uint64_t)(uintptr_t)(_o); }
+
+#define var_isnil(_v)           var_hastag(_v, BE_NIL)
+#define var_isbool(_v)          var_hastag(_v, BE_BOOL)
+#define var_isint(_v)           var_hastag(_v, BE_INT)
+#define var_isreal(_v)          (!nanbox_isboxed(_v) && !nanbox_isfunc(_v))
+#define var_isstr(_v)           var_hastag(_v, BE_STRING)
+#define var_isclosure(_v)       var_hastag(_v, BE_CLOSURE)
+#define var_isntvclos(_v)       var_hastag(_v, BE_NTVCLOS)
+#define var_isntvfunc(_v)       nanbox_isfunc(_v)
+#define var_islntvfunc(_v)      var_hastag(_v, BE_LNTVFUNC)
+#define var_isfunction(_v)      (var_isntvfunc(_v) || var_isclosure(_v) || \
+                                 var_isntvclos(_v) || var_islntvfunc(_v))
+#define var_isproto(_v)         var_hastag(_v, BE_PROTO)
+#define var_isclass(_v)         var_hastag(_v, BE_CLASS)
+#define var_isinstance(_v)      var_hastag(_v, BE_INSTANCE)
+#define var_islist(_v)          var_hastag(_v, BE_LIST)
+#define var_ismap(_v)           var_hastag(_v, BE_MAP)
+#define var_ismodule(_v)        var_hastag(_v, BE_MODULE)
+#define var_isnumber(_v)        (var_isint(_v) || var_isreal(_v))
+
+#define var_setnil(_v)          ((_v)->v.u = nanbox_bits(BE_NIL))
+#define var_setval(_v, _s)      (*(_v) = *(_s))
+#define var_setbool(_v, _b)     { (_v)->v.u = nanbox_bits(BE_BOOL) | ((_b) != 0); }
+#define var_setint(_v, _i)      { (_v)->v.u = nanbox_bits(BE_INT) | (uint32_t)(_i); }
+#define var_setreal(_v, _r)     { (_v)->v.r = (_r); if (!var_isreal(_v)) { \
+                                  (_v)->v.u = nanbox_isboxed(_v) ? NANBOX_NAN : 0; } }
+#define var_setntvfunc(_v, _o)  { (_v)->v.nf = (_o); }
+#define var_setlntvfunc(_v, _o) var_setobj(_v, BE_LNTVFUNC, _o)
+
+#define var_tobool(_v)          cast(bbool, (_v)->v.u & 1)
+#define var_toint(_v)           cast(bint, cast(int32_t, cast(uint32_t, (_v)->v.u)))
+#define var_toreal(_v)          ((_v)->v.r)
+#define var_toobj(_v)           cast(void*, cast(uintptr_t, (_v)->v.u & NANBOX_PAYLOAD))
+#define var_tostr(_v)           cast(bstring*, var_toobj(_v))
+#define var_togc(_v)            cast(bgcobject*, var_toobj(_v))
+#define var_tontvfunc(_v)       ((_v)->v.nf)
+#define var_tolntvfunc(_v)      cast(blntvfunc, cast(uintptr_t, (_v)->v.u & NANBOX_PAYLOAD))
+
+extern const signed char be_nanbox_types[16];
+#else
 #define var_type(_v)            ((_v)->type)
 #define var_basetype(_v)        basetype((_v)->type)
 #define var_istype(_v, _t)      (var_type(_v) == _t)
@@ -175,6 +282,7 @@ typedef const char* (*breader)(void*, size_t*);
 #define var_isclosure(_v)       var_istype(_v, BE_CLOSURE)
 #define var_isntvclos(_v)       var_istype(_v, BE_NTVCLOS)
 #define var_isntvfunc(_v)       var_istype(_v, BE_NTVFUNC)
+#define var_islntvfunc(_v)      var_istype(_v, BE_LNTVFUNC)
 #define var_isfunction(_v)      (var_basetype(_v) == BE_FUNCTION)
 #define var_isproto(_v)         var_istype(_v, BE_PROTO)
 #define var_isclass(_v)         var_istype(_v, BE_CLASS)
@@ -189,16 +297,8 @@ typedef const char* (*breader)(void*, size_t*);
 #define var_setbool(_v, _b)     { var_settype(_v, BE_BOOL); (_v)->v.b = (bbool)(_b); }
 #define var_setint(_v, _i)      { var_settype(_v, BE_INT); (_v)->v.i = (_i); }
 #define var_setreal(_v, _r)     { var_settype(_v, BE_REAL); (_v)->v.r = (_r); }
-#define var_setstr(_v, _s)      var_setobj(_v, BE_STRING, _s)
-#define var_setinstance(_v, _o) var_setobj(_v, BE_INSTANCE, _o)
-#define var_setclass(_v, _o)    var_setobj(_v, BE_CLASS, _o)
-#define var_setclosure(_v, _o)  var_setobj(_v, BE_CLOSURE, _o)
-#define var_setntvclos(_v, _o)  var_setobj(_v, BE_NTVCLOS, _o)
 #define var_setntvfunc(_v, _o)  { (_v)->v.nf = (_o); var_settype(_v, BE_NTVFUNC); }
-#define var_setlist(_v, _o)     var_setobj(_v, BE_LIST, _o)
-#define var_setmap(_v, _o)      var_setobj(_v, BE_MAP, _o)
-#define var_setmodule(_v, _o)   var_setobj(_v, BE_MODULE, _o)
-#define var_setproto(_v, _o)    var_setobj(_v, BE_PROTO, _o)
+#define var_setlntvfunc(_v, _o) { (_v)->v.lf = (_o); var_settype(_v, BE_LNTVFUNC); }
 
 #define var_tobool(_v)          ((_v)->v.b)
 #define var_toint(_v)           ((_v)->v.i)
@@ -207,6 +307,18 @@ typedef const char* (*breader)(void*, size_t*);
 #define var_togc(_v)            ((_v)->v.gc)
 #define var_toobj(_v)           ((_v)->v.p)
 #define var_tontvfunc(_v)       ((_v)->v.nf)
+#define var_tolntvfunc(_v)      ((_v)->v.lf)
+#endif
+
+#define var_setstr(_v, _s)      var_setobj(_v, BE_STRING, _s)
+#define var_setinstance(_v, _o) var_setobj(_v, BE_INSTANCE, _o)
+#define var_setclass(_v, _o)    var_setobj(_v, BE_CLASS, _o)
+#define var_setclosure(_v, _o)  var_setobj(_v, BE_CLOSURE, _o)
+#define var_setntvclos(_v, _o)  var_setobj(_v, BE_NTVCLOS, _o)
+#define var_setlist(_v, _o)     var_setobj(_v, BE_LIST, _o)
+#define var_setmap(_v, _o)      var_setobj(_v, BE_MAP, _o)
+#define var_setmodule(_v, _o)   var_setobj(_v, BE_MODULE, _o)
+#define var_setproto(_v, _o)    var_setobj(_v, BE_PROTO, _o)
 #define var_toidx(_v)           cast_int(var_toint(_v))
 
 const char* be_vtype2str(bvalue *v);
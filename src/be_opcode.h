@@ -49,53 +49,30 @@
 #define ISET_Bx(i)              INS_SETx(i, IBx_MASK, 0)
 #define ISET_sBx(i)             (ISET_Bx(cast_int(i) + IsBx_MAX))
 
+/* the six fused relational instructions share one quickened opcode,
+ * OP_JCMPINT keeps the generic opcode and its A operand in A */
+#define IJCMP_OP(i)             cast(bopcode, OP_JLT + (IGET_RA(i) >> 1))
+#define IJCMP_RA(i)             (IGET_RA(i) & 1)
+#define IJCMP_QUICKEN(i)        (((i) & (IRKB_MASK | IRKC_MASK)) | ISET_OP(OP_JCMPINT) | \
+                                 ISET_RA((IGET_OP(i) - OP_JLT) << 1 | IGET_RA(i)))
+#define IJCMP_GENERIC(i)        (((i) & (IRKB_MASK | IRKC_MASK)) | \
+                                 ISET_OP(IJCMP_OP(i)) | ISET_RA(IJCMP_RA(i)))
+
 typedef enum {
-    /* don't change order */
-/*  opcode           parameters         description */
-    OP_ADD,       /*  A, B, C  |   R(A) <- RK(B) + RK(C) */
-    OP_SUB,       /*  A, B, C  |   R(A) <- RK(B) - RK(C) */
-    OP_MUL,       /*  A, B, C  |   R(A) <- RK(B) * RK(C) */
-    OP_DIV,       /*  A, B, C  |   R(A) <- RK(B) / RK(C) */
-    OP_MOD,       /*  A, B, C  |   R(A) <- RK(B) % RK(C) */
-    OP_LT,        /*  A, B, C  |   R(A) <- RK(B) < RK(C) */
-    OP_LE,        /*  A, B, C  |   R(A) <- RK(B) <= RK(C) */
-    OP_EQ,        /*  A, B, C  |   R(A) <- RK(B) == RK(C) */
-    OP_NE,        /*  A, B, C  |   R(A) <- RK(B) != RK(C) */
-    OP_GT,        /*  A, B, C  |   R(A) <- RK(B) > RK(C) */
-    OP_GE,        /*  A, B, C  |   R(A) <- RK(B) >= RK(C) */
-    OP_AND,       /*  A, B, C  |   R(A) <- RK(B) & RK(C) */
-    OP_OR,        /*  A, B, C  |   R(A) <- RK(B) | RK(C) */
-    OP_XOR,       /*  A, B, C  |   R(A) <- RK(B) ^ RK(C) */
-    OP_SHL,       /*  A, B, C  |   R(A) <- RK(B) << RK(C) */
-    OP_SHR,       /*  A, B, C  |   R(A) <- RK(B) >> RK(C) */
-    OP_RANGE,     /*  A, B, C  |   R(A) <- range(RK(B), RK(C)) */
-    OP_NEG,       /*  A, B     |   R(A) <- -RK(B) */
-    OP_FLIP,      /*  A, B     |   R(A) <- ~RK(B) */
-    OP_LDNIL,     /*  A        |   R(A) <- nil */
-    OP_LDBOOL,    /*  A, B, C  |   R(A) <- cast_bool(B), if(C): pc++ */
-    OP_LDINT,     /*  A, sBx   |   R(A) <- sBx */
-    OP_LDCONST,   /*  A, Bx    |   R(A) <- K(Bx) */
-    OP_MOVE,      /*  A, B, C  |   R(A) <- RK(B) */
-    OP_GETGBL,    /*  A, Bx    |   R(A) <- GLOBAL(Bx) */
-    OP_SETGBL,    /*  A, Bx    |   R(A) -> GLOBAL(Bx) */
-    OP_GETUPV,    /*  A, Bx    |   R(A) <- UPVALUE(Bx)*/
-    OP_SETUPV,    /*  A, Bx    |   R(A) -> UPVALUE(Bx)*/
-    OP_JMP,       /*  sBx      |   pc <- pc + sBx */
-    OP_JMPT,      /*  A, sBx   |   if(R(A)): pc <- pc + sBx  */
-    OP_JMPF,      /*  A, sBx   |   if(not R(A)): pc <- pc + sBx  */
-    OP_CALL,      /*  A        |   CALL(R(A), B) */
-    OP_RET,       /*  A, B     |   if (R(A)) R(-1) <- RK(B) else R(-1) <- nil */
-    OP_CLOSURE,   /*  A, Bx    |   R(A) <- CLOSURE(proto_table[Bx])*/
-    OP_GETMBR,    /*  A, B, C  |   R(A) <- RK(B).RK(C) */
-    OP_GETMET,    /*  A, B, C  |   R(A) <- RK(B).RK(C), R(A+1) <- RK(B) */
-    OP_SETMBR,    /*  A, B, C  |   R(A).RK(B) <- RK(C) */
-    OP_GETIDX,    /*  A, B, C  |   R(A) <- RK(B)[RK(C)] */
-    OP_SETIDX,    /*  A, B, C  |   R(A)[RK(B)] <- RK(C) */
-    OP_SETSUPER,  /*  A, B     |   class:R(A) set super with class:RK(B) */
-    OP_CLOSE,     /*  A        |   close upvalues */
-    OP_IMPORT     /*  A, B     |   R(A) <- import module from name RK(B) */
+    #define OPCODE(opc) OP_##opc
+    #include "be_opcodes.h"
+    #undef OPCODE
 } bopcode;
 
+/* the builtin functions inlined by OP_INTRIN, the B operand */
+typedef enum {
+    INTRIN_SIZE,
+    INTRIN_TYPE,
+    INTRIN_STR,
+    INTRIN_INT,
+    INTRIN_REAL
+} bintrinsic;
+
 const char *be_opcode2str(bopcode op);
 
 #endif
@@ -0,0 +1,66 @@
+/* define opcode, don't change order */
+/*  opcode             parameters         description */
+OPCODE(ADD),        /*  A, B, C  |   R(A) <- RK(B) + RK(C) */
+OPCODE(SUB),        /*  A, B, C  |   R(A) <- RK(B) - RK(C) */
+OPCODE(MUL),        /*  A, B, C  |   R(A) <- RK(B) * RK(C) */
+OPCODE(DIV),        /*  A, B, C  |   R(A) <- RK(B) / RK(C) */
+OPCODE(MOD),        /*  A, B, C  |   R(A) <- RK(B) % RK(C) */
+OPCODE(LT),         /*  A, B, C  |   R(A) <- RK(B) < RK(C) */
+OPCODE(LE),         /*  A, B, C  |   R(A) <- RK(B) <= RK(C) */
+OPCODE(EQ),         /*  A, B, C  |   R(A) <- RK(B) == RK(C) */
+OPCODE(NE),         /*  A, B, C  |   R(A) <- RK(B) != RK(C) */
+OPCODE(GT),         /*  A, B, C  |   R(A) <- RK(B) > RK(C) */
+OPCODE(GE),         /*  A, B, C  |   R(A) <- RK(B) >= RK(C) */
+OPCODE(AND),        /*  A, B, C  |   R(A) <- RK(B) & RK(C) */
+OPCODE(OR),         /*  A, B, C  |   R(A) <- RK(B) | RK(C) */
+OPCODE(XOR),        /*  A, B, C  |   R(A) <- RK(B) ^ RK(C) */
+OPCODE(SHL),        /*  A, B, C  |   R(A) <- RK(B) << RK(C) */
+OPCODE(SHR),        /*  A, B, C  |   R(A) <- RK(B) >> RK(C) */
+OPCODE(RANGE),      /*  A, B, C  |   R(A) <- range(RK(B), RK(C)) */
+OPCODE(NEG),        /*  A, B     |   R(A) <- -RK(B) */
+OPCODE(FLIP),       /*  A, B     |   R(A) <- ~RK(B) */
+OPCODE(LDNIL),      /*  A        |   R(A) <- nil */
+OPCODE(LDBOOL),     /*  A, B, C  |   R(A) <- cast_bool(B), if(C): pc++ */
+OPCODE(LDINT),      /*  A, sBx   |   R(A) <- sBx */
+OPCODE(LDCONST),    /*  A, Bx    |   R(A) <- K(Bx) */
+OPCODE(MOVE),       /*  A, B, C  |   R(A) <- RK(B) */
+OPCODE(GETGBL),     /*  A, Bx    |   R(A) <- GLOBAL(Bx) */
+OPCODE(SETGBL),     /*  A, Bx    |   R(A) -> GLOBAL(Bx) */
+OPCODE(GETUPV),     /*  A, Bx    |   R(A) <- UPVALUE(Bx)*/
+OPCODE(SETUPV),     /*  A, Bx    |   R(A) -> UPVALUE(Bx)*/
+OPCODE(JMP),        /*  sBx      |   pc <- pc + sBx */
+OPCODE(JMPT),       /*  A, sBx   |   if(R(A)): pc <- pc + sBx  */
+OPCODE(JMPF),       /*  A, sBx   |   if(not R(A)): pc <- pc + sBx  */
+OPCODE(CALL),       /*  A, B, C  |   CALL(R(A), B), C: tail call */
+OPCODE(RET),        /*  A, B     |   if (R(A)) R(-1) <- RK(B) else R(-1) <- nil */
+OPCODE(CLOSURE),    /*  A, Bx    |   R(A) <- CLOSURE(proto_table[Bx])*/
+OPCODE(GETMBR),     /*  A, B, C  |   R(A) <- RK(B).RK(C) */
+OPCODE(GETMET),     /*  A, B, C  |   R(A) <- RK(B).RK(C), R(A+1) <- RK(B) */
+OPCODE(SETMBR),     /*  A, B, C  |   R(A).RK(B) <- RK(C) */
+OPCODE(GETIDX),     /*  A, B, C  |   R(A) <- RK(B)[RK(C)] */
+OPCODE(SETIDX),     /*  A, B, C  |   R(A)[RK(B)] <- RK(C) */
+OPCODE(SETSUPER),   /*  A, B     |   class:R(A) set super with class:RK(B) */
+OPCODE(CLOSE),      /*  A        |   close upvalues */
+OPCODE(IMPORT),     /*  A, B     |   R(A) <- import module from name RK(B) */
+OPCODE(JLT),        /*  A, B, C  |   if ((RK(B) < RK(C)) != A) pc++ */
+OPCODE(JLE),        /*  A, B, C  |   if ((RK(B) <= RK(C)) != A) pc++ */
+OPCODE(JEQ),        /*  A, B, C  |   if ((RK(B) == RK(C)) != A) pc++ */
+OPCODE(JNE),        /*  A, B, C  |   if ((RK(B) != RK(C)) != A) pc++ */
+OPCODE(JGT),        /*  A, B, C  |   if ((RK(B) > RK(C)) != A) pc++ */
+OPCODE(JGE),        /*  A, B, C  |   if ((RK(B) >= RK(C)) != A) pc++ */
+OPCODE(ADDINT),     /*  A, B, C  |   R(A) <- RK(B) + RK(C) (quickened: int, int) */
+OPCODE(ADDREAL),    /*  A, B, C  |   R(A) <- RK(B) + RK(C) (quickened: real, real) */
+OPCODE(SUBINT),     /*  A, B, C  |   R(A) <- RK(B) - RK(C) (quickened: int, int) */
+OPCODE(SUBREAL),    /*  A, B, C  |   R(A) <- RK(B) - RK(C) (quickened: real, real) */
+OPCODE(MULINT),     /*  A, B, C  |   R(A) <- RK(B) * RK(C) (quickened: int, int) */
+OPCODE(MULREAL),    /*  A, B, C  |   R(A) <- RK(B) * RK(C) (quickened: real, real) */
+OPCODE(DIVINT),     /*  A, B, C  |   R(A) <- RK(B) / RK(C) (quickened: int, int) */
+OPCODE(DIVREAL),    /*  A, B, C  |   R(A) <- RK(B) / RK(C) (quickened: real, real) */
+OPCODE(JCMPINT),    /*  A, B, C  |   the fused relational IJCMP_OP(A) (quickened: int, int) */
+OPCODE(FORPREP),    /*  A, B, C  |   R(A+1) <- RK(B), R(A+2) <- RK(C), if (RK(B) <= RK(C)) { R(A) <- RK(B), pc++ } */
+OPCODE(FORLOOP),    /*  A, sBx   |   if (R(A+1) < R(A+2)) { R(A) <- ++R(A+1), pc += sBx } */
+OPCODE(ITERPREP),   /*  A        |   R(A+1) <- iterator(R(A)) */
+OPCODE(ITERNEXT),   /*  A, B     |   if (hasnext(R(A+1))) { R(B) <- next(R(A+1)), pc++ } */
+OPCODE(SETLIST),    /*  A, B     |   R(A).append(R(A+1)), ..., R(A).append(R(A+B)) */
+OPCODE(SETMAP),     /*  A, B     |   R(A).insert(R(A+1), R(A+2)), ..., R(A).insert(R(A+2B-1), R(A+2B)), the nil keys are ignored */
+OPCODE(INTRIN)      /*  A, B, C  |   R(A) <- intrinsic B(R(A+1)), or CALL(R(A) <- GLOBAL(C), 1) */
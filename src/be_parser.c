@@ -13,6 +13,7 @@
 #include "be_opcode.h"
 #include "be_debug.h"
 #include "be_exec.h"
+#include "be_gc.h"
 
 #define OP_NOT_BINARY           TokenNone
 #define OP_NOT_UNARY            TokenNone
@@ -23,6 +24,9 @@
 #define FUNC_METHOD             1
 #define FUNC_ANONYMOUS          2
 
+#define LIST_BATCH              32 /* elements per SETLIST */
+#define MAP_BATCH               16 /* key-value pairs per SETMAP */
+
 /* get binary operator priority */
 #define binary_op_prio(op)      (binary_op_prio_tab[cast_int(op) - OptAdd])
 
@@ -178,11 +182,13 @@ static void begin_func(bparser *parser, bfuncinfo *finfo, bblockinfo *binfo)
     finfo->binfo = NULL;
     finfo->pc = 0;
     finfo->jpc = NO_JUMP;
+    finfo->lasttarget = NO_JUMP;
     finfo->flag = 0;
     parser->finfo = finfo;
 #if BE_DEBUG_RUNTIME_INFO
     be_vector_init(vm, &finfo->linevec, sizeof(blineinfo));
     proto->source = be_newstr(vm, parser->lexer.fname);
+    be_gc_barrier(vm, proto);
     proto->lineinfo = be_vector_data(&finfo->linevec);
     proto->nlineinfo = be_vector_capacity(&finfo->linevec);
 #endif
@@ -200,7 +206,7 @@ static void setupvals(bfuncinfo *finfo)
         bupvaldesc *upvals = be_malloc(
                 finfo->lexer->vm, sizeof(bupvaldesc) * nupvals);
         while ((node = be_map_next(map, &iter)) != NULL) {
-            uint32_t v = (uint32_t)node->value.v.i;
+            uint32_t v = (uint32_t)var_toint(&node->value);
             int idx = upval_index(v);
             upvals[idx].idx = upval_target(v);
             upvals[idx].instack = upval_instack(v);
@@ -275,7 +281,7 @@ static int find_localvar(bfuncinfo *finfo, bstring *s, int begin)
     int i, count = be_list_count(finfo->local);
     bvalue *var = be_list_data(finfo->local);
     for (i = count - 1; i >= begin; --i) {
-        if (be_eqstr(var[i].v.s, s)) {
+        if (be_eqstr(var_tostr(var + i), s)) {
             return i;
         }
     }
@@ -302,7 +308,7 @@ static int find_upval(bfuncinfo *finfo, bstring *s)
 {
     bvalue *desc = be_map_findstr(finfo->upval, s);
     if (desc) {
-        return upval_index(desc->v.i);
+        return upval_index(var_toint(desc));
     }
     return -1;
 }
@@ -356,8 +362,7 @@ static void new_class(bparser *parser, bstring *name, bclass *c, bexpdesc *e)
         e->v.idx = be_global_new(parser->vm, name);
         var = be_global_var(parser->vm, e->v.idx);
     }
-    var_settype(var, BE_CLASS);
-    var->v.p = c;
+    var_setclass(var, c);
 }
 
 static int singlevaraux(bvm *vm, bfuncinfo *finfo, bstring *s, bexpdesc *var)
@@ -440,6 +445,7 @@ static bproto* funcbody(bparser *parser, bstring *name, int type)
     /* '(' varlist ')' block 'end' */
     begin_func(parser, &finfo, &binfo);
     finfo.proto->name = name;
+    be_gc_barrier(parser->vm, finfo.proto);
     finfo.flag = (bbyte)type;
     if (type & FUNC_METHOD) {
         new_localvar(parser, parser_newstr(parser, "self"));
@@ -502,6 +508,7 @@ static void lambda_expr(bparser *parser, bexpdesc *e)
     scan_next_token(parser); /* skip '/' */
     begin_func(parser, &finfo, &binfo);
     finfo.proto->name = name;
+    be_gc_barrier(parser->vm, finfo.proto);
     finfo.flag = (bbyte)FUNC_ANONYMOUS;
     lambda_varlist(parser);
     expr(parser, &e1);
@@ -526,35 +533,21 @@ static void new_primtype(bparser *parser, const char *type, bexpdesc *e)
     e->type = ETLOCAL;
 }
 
-static void list_nextmember(bparser *parser, bexpdesc *l)
+static void list_nextmember(bparser *parser)
 {
-    bexpdesc e, key, v = *l;
+    bexpdesc e;
     bfuncinfo *finfo = parser->finfo;
-    int base;
-
-    init_exp(&key, ETSTRING, 0);
-    key.v.s = parser_newstr(parser, "append");
-    be_code_member(finfo, &v, &key);
-    base = be_code_getmethod(finfo, &v);
     /* copy source value to next register */
     expr(parser, &e);
     check_var(parser, &e);
     be_code_nextreg(finfo, &e);
-    be_code_call(finfo, base, 2);
-    be_code_freeregs(finfo, 1); /* free return value */
 }
 
-static void map_nextmember(bparser *parser, bexpdesc *l)
+static void map_nextmember(bparser *parser)
 {
-    bexpdesc e, key, v = *l;
+    bexpdesc e;
     bfuncinfo *finfo = parser->finfo;
-    int base;
-
-    init_exp(&key, ETSTRING, 0);
-    key.v.s = parser_newstr(parser, "insert");
-    be_code_member(finfo, &v, &key);
-    base = be_code_getmethod(finfo, &v);
-    /* copy source value to next register */
+    /* copy key and value to next registers */
     expr(parser, &e); /* key */
     check_var(parser, &e);
     be_code_nextreg(finfo, &e);
@@ -562,34 +555,50 @@ static void map_nextmember(bparser *parser, bexpdesc *l)
     expr(parser, &e); /* value */
     check_var(parser, &e);
     be_code_nextreg(finfo, &e);
-    be_code_call(finfo, base, 3);
-    be_code_freeregs(finfo, 1); /* free return value */
 }
 
+/* the elements are stored to the registers following the list and
+ * appended with SETLIST for every LIST_BATCH elements */
 static void list_expr(bparser *parser, bexpdesc *e)
 {
+    int n = 0;
     /* '[' {expr ','} [expr] ']' */
     new_primtype(parser, "list", e); /* new list */
     while (next_type(parser) != OptRSB) {
-        list_nextmember(parser, e);
+        list_nextmember(parser);
+        if (++n == LIST_BATCH) {
+            be_code_setlist(parser->finfo, e->v.idx, n);
+            n = 0;
+        }
         if (!match_skip(parser, OptComma)) { /* ',' */
             break;
         }
     }
+    if (n) {
+        be_code_setlist(parser->finfo, e->v.idx, n);
+    }
     e->type = ETREG;
     match_token(parser, OptRSB); /* skip ']' */
 }
 
 static void map_expr(bparser *parser, bexpdesc *e)
 {
+    int n = 0;
     /* '{' {expr ':' expr ','} [expr ':' expr] '}' */
     new_primtype(parser, "map", e); /* new map */
     while (next_type(parser) != OptRBR) {
-        map_nextmember(parser, e);
+        map_nextmember(parser);
+        if (++n == MAP_BATCH) {
+            be_code_setmap(parser->finfo, e->v.idx, n);
+            n = 0;
+        }
         if (!match_skip(parser, OptComma)) { /* ',' */
             break;
         }
     }
+    if (n) {
+        be_code_setmap(parser->finfo, e->v.idx, n);
+    }
     e->type = ETREG;
     match_token(parser, OptRBR); /* skip '}' */
 }
@@ -612,18 +621,42 @@ static int exprlist(bparser *parser, bexpdesc *e)
     return n;
 }
 
+/* get the intrinsic of the builtin function 'e', a global variable
+ * with the same name shadows the builtin and is not an intrinsic */
+static int find_intrinsic(bparser *parser, bexpdesc *e)
+{
+    static const char *const names[] = {
+        "size", "type", "str", "int", "real" /* order of bintrinsic */
+    };
+    bvm *vm = parser->vm;
+    if (e->type == ETGLOBAL && e->v.idx < be_builtin_count(vm)
+            && e->v.idx < (1 << IRKC_BITS)) {
+        int i;
+        for (i = 0; i < cast_int(array_count(names)); ++i) {
+            bstring *s = parser_newstr(parser, names[i]);
+            if (be_builtin_find(vm, s) == e->v.idx) {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
 static void call_expr(bparser *parser, bexpdesc *e)
 {
     bexpdesc args;
     bfuncinfo *finfo = parser->finfo;
     int argc = 0, base = finfo->freereg;
-    int ismember = e->type == ETMEMBER;
+    int ismember = e->type == ETMEMBER, intrin;
 
     /* func '(' [exprlist] ')' */
     check_var(parser, e);
+    intrin = find_intrinsic(parser, e);
     /* code function index to next register */
     if (ismember) {
         base = be_code_getmethod(finfo, e);
+    } else if (intrin >= 0) { /* the function is loaded after arguments */
+        base = be_code_allocregs(finfo, 1);
     } else {
         base = be_code_nextreg(finfo, e);
     }
@@ -633,7 +666,11 @@ static void call_expr(bparser *parser, bexpdesc *e)
     }
     match_token(parser, OptRBK); /* skip ')' */
     argc += ismember;
-    be_code_call(finfo, base, argc);
+    if (intrin >= 0) {
+        be_code_intrinsic(finfo, base, argc, intrin, e->v.idx);
+    } else {
+        be_code_call(finfo, base, argc);
+    }
     if (e->type != ETREG) {
         e->type = ETREG;
         e->v.idx = base;
@@ -966,67 +1003,99 @@ static void for_itvar(bparser *parser, bexpdesc *e)
         init_exp(e, ETLOCAL, idx);
         scan_next_token(parser);
     } else {
+        init_exp(e, ETVOID, 0); /* push_error() does not return */
         push_error(parser,
             "missing iteration variable before '%s'",
             token2str(parser));
     }
 }
 
-static void for_init(bparser *parser, bexpdesc *v)
+/* numeric loop:
+ *     .it, .lim = lower, upper (FORPREP)
+ * other iterable objects:
+ *     .obj = expr, .it = iterator(.obj) (ITERPREP)
+ * the result is the exit jump of the numeric loop, otherwise NO_JUMP
+ * and v is set to the '.obj' variable.
+ */
+static int for_init(bparser *parser, bexpdesc *var, bexpdesc *v)
 {
-    bexpdesc e;
+    int obj;
     bstring *s;
+    int jmp;
     bfuncinfo *finfo = parser->finfo;
 
-    /* .it = __iterator__(expr) */
-    s = parser_newstr(parser, "__iterator__");
-    init_exp(&e, ETGLOBAL, be_builtin_find(parser->vm, s));
-    be_code_nextreg(finfo, &e); /* code function '__iterator__' */
     expr(parser, v);
     check_var(parser, v);
-    be_code_nextreg(finfo, v);
-    be_code_call(finfo, e.v.idx, 1); /* call __iterator__(expr) */
-    be_code_freeregs(finfo, 1); /* free register of __iterator__ */
+    jmp = be_code_forprep(finfo, v, var->v.idx);
+    if (jmp != NO_JUMP) { /* the iterable object is a range literal */
+        s = parser_newstr(parser, ".it");
+        init_exp(v, ETLOCAL, new_localvar(parser, s));
+        s = parser_newstr(parser, ".lim");
+        new_localvar(parser, s);
+        return jmp;
+    }
+    s = parser_newstr(parser, ".obj");
+    obj = be_code_nextreg(finfo, v);
+    new_localvar(parser, s);
     s = parser_newstr(parser, ".it");
-    init_exp(v, ETLOCAL, new_localvar(parser, s));
+    new_localvar(parser, s);
+    be_code_iterprep(finfo, obj);
+    init_exp(v, ETLOCAL, obj);
+    return NO_JUMP;
 }
 
 /*
- * while (__hasnext__(.it))
- *     var = __next__(.it)
- *     stmtlist
- * end
+ * loop: ITERNEXT .obj, var  -- skip the exit jump if the iterator has next
+ * JMP exit
+ * stmtlist
+ * JMP loop
+ * exit:
  */
-static void for_iter(bparser *parser, bexpdesc *v, bexpdesc *it)
+static void for_iter(bparser *parser, bexpdesc *v, bexpdesc *obj)
 {
-    bexpdesc e;
-    bstring *s;
-    int brk;
     bfuncinfo *finfo = parser->finfo;
+    bblockinfo *binfo = finfo->binfo;
+    int exit;
 
     block_setloop(finfo);
-    /* __hasnext__(.it) */
-    s = parser_newstr(parser, "__hasnext__");
-    init_exp(&e, ETGLOBAL, be_builtin_find(parser->vm, s));
-    be_code_nextreg(finfo, &e); /* code function '__hasnext__' */
-    be_code_nextreg(finfo, it); /* code argv[0]: '.it' */
-    be_code_call(finfo, e.v.idx, 1); /* call __hasnext__(.it) */
-    be_code_goiftrue(finfo, &e);
-    brk = e.f;
-    /* var = __next__(.it) */
-    s = parser_newstr(parser, "__next__");
-    init_exp(&e, ETGLOBAL, be_builtin_find(parser->vm, s));
-    be_code_nextreg(finfo, &e); /* code function '__next__' */
-    be_code_nextreg(finfo, it); /* code argv[0]: '.it' */
-    be_code_call(finfo, e.v.idx, 1); /* call __next__(.it) */
-    be_code_setvar(finfo, v, &e); /* code var = __next__(.it) */
+    exit = be_code_iternext(finfo, obj->v.idx, v->v.idx);
+    be_code_conjump(finfo, &binfo->breaklist, exit);
     stmtlist(parser);
+    be_code_patchjump(finfo, binfo->continuelist);
+    be_code_close(finfo, 0); /* close the upvalues of each iteration */
+    be_code_jumpto(finfo, binfo->beginpc);
+    be_code_patchjump(finfo, binfo->breaklist);
+    binfo->isloop = 0; /* the jumps of the loop were coded */
+    end_block(parser);
+}
+
+/*
+ * FORPREP var, lower, upper  -- skip the exit jump if lower <= upper
+ * JMP exit
+ * body: stmtlist
+ * FORLOOP var, body
+ * exit:
+ */
+static void for_range(bparser *parser, bexpdesc *v, int exit)
+{
+    bfuncinfo *finfo = parser->finfo;
+    bblockinfo *binfo = finfo->binfo;
+    int body = finfo->pc;
+
+    block_setloop(finfo);
+    be_code_conjump(finfo, &binfo->breaklist, exit);
+    stmtlist(parser);
+    be_code_patchjump(finfo, binfo->continuelist);
+    be_code_close(finfo, 0); /* close the upvalues of each iteration */
+    be_code_forloop(finfo, v->v.idx, body);
+    be_code_patchjump(finfo, binfo->breaklist);
+    binfo->isloop = 0; /* the jumps of the loop were coded */
     end_block(parser);
-    be_code_patchjump(finfo, brk);
 }
 
 static void for_stmt(bparser *parser)
 {
+    int exit;
     bblockinfo binfo;
     bexpdesc var, iter;
     /* FOR (ID : expr) block END */
@@ -1035,9 +1104,13 @@ static void for_stmt(bparser *parser)
     begin_block(parser->finfo, &binfo, 0);
     for_itvar(parser, &var);
     match_token(parser, OptColon); /* skip ':' */
-    for_init(parser, &iter);
+    exit = for_init(parser, &var, &iter);
     match_token(parser, OptRBK); /* skip ')' */
-    for_iter(parser, &var, &iter);
+    if (exit != NO_JUMP) {
+        for_range(parser, &var, exit);
+    } else {
+        for_iter(parser, &var, &iter);
+    }
     match_token(parser, KeyEnd); /* skip 'end' */
 }
 
@@ -1306,6 +1379,7 @@ static void mainfunc(bparser *parser, bclosure *cl)
     begin_func(parser, &finfo, &binfo);
     finfo.proto->argc = 0; /* args */
     finfo.proto->name = be_newstr(parser->vm, "main");
+    be_gc_barrier(parser->vm, finfo.proto);
     cl->proto = finfo.proto;
     be_remove(parser->vm, -3);  /* pop proto from stack */
     stmtlist(parser);
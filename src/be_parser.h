@@ -65,6 +65,7 @@ typedef struct bfuncinfo {
 #endif
     int pc; /* program count */
     int jpc;  /* list of pending jumps to 'pc' */
+    int lasttarget; /* the last jump target */
     bbyte freereg; /* first free register */
     bbyte flag; /* anonymous function */
 } bfuncinfo;
@@ -64,7 +64,10 @@ static int i_hashnext(bvm *vm)
     be_getmember(vm, 1, ".obj");
     be_getmember(vm, 1, ".iter");
     be_getmember(vm, -2, "__upper__");
-    if (!be_isint(vm, -2) || be_toint(vm, -2) < be_toint(vm, -1)) {
+    if (!be_isint(vm, -2)) { /* the first iteration */
+        be_getmember(vm, -3, "__lower__");
+        be_pushbool(vm, be_toint(vm, -1) <= be_toint(vm, -2));
+    } else if (be_toint(vm, -2) < be_toint(vm, -1)) {
         be_pushbool(vm, btrue);
     } else {
         be_pushbool(vm, bfalse);
@@ -90,12 +93,12 @@ static int i_next(bvm *vm)
 static int m_iter(bvm *vm)
 {
     static const bnfuncinfo members[] = {
-        { ".obj", NULL },
-        { ".iter", NULL },
-        { "init", i_init },
-        { "hasnext", i_hashnext },
-        { "next", i_next },
-        { NULL, NULL }
+        { ".obj", NULL, NULL },
+        { ".iter", NULL, NULL },
+        { "init", i_init, NULL },
+        { "hasnext", i_hashnext, NULL },
+        { "next", i_next, NULL },
+        { NULL, NULL, NULL }
     };
     be_pushclass(vm, "iterator", members);
     be_pushvalue(vm, 1);
@@ -108,15 +111,15 @@ static int m_iter(bvm *vm)
 void be_load_rangelib(bvm *vm)
 {
     static const bnfuncinfo members[] = {
-        { "__lower__", NULL },
-        { "__upper__", NULL },
-        { "init", m_init },
-        { "tostring", m_tostring },
-        { "lower", m_lower },
-        { "upper", m_upper },
-        { "setrange", m_setrange },
-        { "iter", m_iter },
-        { NULL, NULL }
+        { "__lower__", NULL, NULL },
+        { "__upper__", NULL, NULL },
+        { "init", m_init, NULL },
+        { "tostring", m_tostring, NULL },
+        { "lower", m_lower, NULL },
+        { "upper", m_upper, NULL },
+        { "setrange", m_setrange, NULL },
+        { "iter", m_iter, NULL },
+        { NULL, NULL, NULL }
     };
     be_regclass(vm, "range", members);
 }
@@ -4,20 +4,20 @@
 #include "be_constobj.h"
 #include <string.h>
 
-#define next(_s)    cast(void*, cast(bstring*, (_s)->next))
+#define next(_s)    (cast(bsstring*, _s)->next)
 #define sstr(_s)    cast(char*, cast(bsstring*, _s) + 1)
 #define lstr(_s)    cast(char*, cast(blstring*, _s) + 1)
 #define cstr(_s)    (cast(bcstring*, s)->s)
 
 #define be_define_const_str(_name, _s, _hash, _extra, _len, _next) \
 const bcstring be_const_str_##_name = { \
-    .next = (bgcobject *)_next, \
     .type = BE_STRING, \
     .marked = GC_CONST, \
     .extra = _extra, \
     .slen = _len, \
     .hash = _hash, \
-    .s = _s \
+    .s = _s, \
+    .next = _next \
 }
 
 /* const string table */
@@ -64,7 +64,7 @@ static void resize(bvm *vm, int size)
         while (p) { /* for each node in the list */
             bstring *hnext = next(p);
             uint32_t hash = be_strhash(p) & (size - 1);
-            p->next = cast(void*, tab->table[hash]);
+            next(p) = tab->table[hash];
             tab->table[hash] = p;
             p = hnext;
         }
@@ -144,7 +144,7 @@ static bstring* find_conststr(const char *str, size_t len)
     const struct bconststrtab *tab = &m_const_string_table;
     uint32_t hash = str_hash(str, len);
     bcstring *s = (bcstring*)tab->table[hash % tab->size];
-    for (; s != NULL; s = next(s)) {
+    for (; s != NULL; s = cast(bcstring*, s->next)) {
         if (len == s->slen && !strncmp(str, s->s, len)) {
             return (bstring*)s;
         }
@@ -162,13 +162,19 @@ static bstring* newshortstr(bvm *vm, const char *str, size_t len)
 
     for (s = *list; s != NULL; s = next(s)) {
         if (len == s->slen && !strncmp(str, sstr(s), len)) {
+            if (gc_isdead(vm, s)) { /* not yet swept */
+                gc_setwhite(vm, s);
+            }
             return s;
         }
     }
     s = createstrobj(vm, len, 0);
+    /* the collection may have resized the string table */
+    size = vm->strtab.size;
+    list = vm->strtab.table + (hash & (size - 1));
     memcpy(cast(char *, sstr(s)), str, len);
     s->extra = 0;
-    s->next = cast(void*, *list);
+    next(s) = *list;
 #if BE_STR_HASH_CACHE
     cast(bsstring*, s)->hash = hash;
 #endif
@@ -212,32 +218,62 @@ bstring *be_newstrn(bvm *vm, const char *str, size_t len)
     return newlongstr(vm, str, len); /* long string */
 }
 
-void be_gcstrtab(bvm *vm)
+/* sweep a bucket of the string table, the result is the number of
+ * the strings visited, or -1 when the 'index' is beyond the table. the
+ * short strings in the GC pages are swept with the pages instead */
+int be_gcstrtab(bvm *vm, int index)
 {
     struct bstringtable *tab = &vm->strtab;
-    int size = tab->size, i;
-    for (i = 0; i < size; ++i) {
-        bstring **list = tab->table + i;
-        bstring *prev = NULL, *node, *next;
-        for (node = *list; node; node = next) {
-            next = next(node);
-            if (!gc_isfixed(node) && gc_iswhite(node)) {
-                free_sstring(vm, node);
-                tab->count--;
-                if (prev) { /* link list */
-                    prev->next = cast(void*, next);
-                } else {
-                    *list = next;
-                }
+    bstring **list, *prev = NULL, *node, *next;
+    int count = 0;
+    if (index >= tab->size) {
+        return -1;
+    }
+    list = tab->table + index;
+    for (node = *list; node; node = next, ++count) {
+        next = next(node);
+        if (!gc_isfixed(node) && gc_isdead(vm, node)) {
+            free_sstring(vm, node);
+            tab->count--;
+            if (prev) { /* link list */
+                next(prev) = next;
             } else {
-                prev = node;
-                gc_setwhite(node);
+                *list = next;
             }
+        } else {
+            prev = node;
+            be_gc_survive(vm, gc_object(node));
         }
     }
-    if (tab->count < size >> 2 && size > 8) {
-        resize(vm, size >> 1);
+    return count;
+}
+
+/* shrink the string table when the sweep has freed most strings */
+void be_gcstrtab_shrink(bvm *vm)
+{
+    struct bstringtable *tab = &vm->strtab;
+    if (tab->count < tab->size >> 2 && tab->size > 8) {
+        resize(vm, tab->size >> 1);
+    }
+}
+
+/* remove a dead short string from the string table and free it */
+void be_gcfreestr(bvm *vm, bstring *s)
+{
+    struct bstringtable *tab = &vm->strtab;
+    bstring **list = tab->table + (be_strhash(s) & (tab->size - 1));
+    bstring *node = *list, *prev = NULL;
+    for (; node != s; node = next(node)) {
+        be_assert(node != NULL);
+        prev = node;
+    }
+    if (prev) { /* link list */
+        next(prev) = next(s);
+    } else {
+        *list = next(s);
     }
+    free_sstring(vm, s);
+    tab->count--;
 }
 
 uint32_t be_strhash(bstring *s)
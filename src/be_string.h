@@ -10,6 +10,7 @@ typedef struct {
 #if BE_STR_HASH_CACHE
     uint32_t hash;
 #endif
+    bstring *next; /* the next string of the bucket in the string table */
     /* char s[]; */
 } bsstring;
 
@@ -19,10 +20,11 @@ typedef struct {
     /* char s[]; */
 } blstring;
 
-typedef struct {
+typedef struct bcstring {
     bstring_header;
     uint32_t hash;
     const char *s;
+    const struct bcstring *next; /* the next string of the bucket */
 } bcstring;
 
 #define str_len(_s) \
@@ -41,7 +43,9 @@ int be_eqstr(bstring *s1, bstring *s2);
 uint32_t str_hash(const char *str, size_t len);
 bstring* be_newstr(bvm *vm, const char *str);
 bstring* be_newstrn(bvm *vm, const char *str, size_t len);
-void be_gcstrtab(bvm *vm);
+int be_gcstrtab(bvm *vm, int index);
+void be_gcstrtab_shrink(bvm *vm);
+void be_gcfreestr(bvm *vm, bstring *s);
 uint32_t be_strhash(bstring *s);
 const char* be_str2cstr(bstring *s);
 void be_str_setextra(bstring *s, int extra);
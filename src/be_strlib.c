@@ -67,7 +67,7 @@ static void sim2str(bvm *vm, bvalue *v)
         break;
     case BE_STRING:
         return;
-    case BE_CLOSURE: case BE_NTVCLOS: case BE_NTVFUNC:
+    case BE_CLOSURE: case BE_NTVCLOS: case BE_NTVFUNC: case BE_LNTVFUNC:
         sprintf(sbuf, "<function: %p>", var_toobj(v));
         break;
     case BE_CLASS:
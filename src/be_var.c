@@ -91,8 +91,8 @@ bstring* be_builtin_name(bvm *vm, int index)
     bmap *map = builtin(vm).vtab;
     bmapnode *end, *node = map->slots;
     for (end = node + map->size; node < end; ++node) {
-        if (var_isstr(&node->key) && node->value.v.i == index) {
-            return node->key.v.s;
+        if (var_isstr(&node->key) && var_toint(&node->value) == index) {
+            return var_tostr(&node->key);
         }
     }
     return NULL;
@@ -5,6 +5,7 @@
 #include "be_class.h"
 #include "be_func.h"
 #include "be_vector.h"
+#include "be_list.h"
 #include "be_map.h"
 #include "be_module.h"
 #include "be_mem.h"
@@ -13,82 +14,215 @@
 #include "be_exec.h"
 #include "be_debug.h"
 #include "be_libs.h"
+#include "be_jit.h"
 #include <string.h>
 
 #define NOT_METHOD      BE_NONE
+#define CALLSTACK_INIT  16 /* preallocated call frames */
 
 #define vm_error(vm, ...) \
     be_pusherror(vm, be_pushfstring(vm, __VA_ARGS__))
 
-#define RA(i)   (vm->reg + IGET_RA(i))
-#define RKB(i)  ((isKB(i) ? curcl(vm)->proto->ktab \
-                          : vm->reg) + KR2idx(IGET_RKB(i)))
-#define RKC(i)  ((isKC(i) ? curcl(vm)->proto->ktab \
-                          : vm->reg) + KR2idx(IGET_RKC(i)))
+#if BE_USE_COMPUTED_GOTO && !defined(__GNUC__)
+  #undef BE_USE_COMPUTED_GOTO /* labels as values is a GNU C extension */
+  #define BE_USE_COMPUTED_GOTO  0
+#endif
+
+#if BE_USE_COMPUTED_GOTO
+  /* threaded code: each handler jumps directly to the next one */
+  #define vm_exec_loop()        dispatch_current();
+  #define opcase(opc)           L_##opc
+  #define dispatch_current() \
+      __extension__ ({ ins = *ip; goto *disptab[IGET_OP(ins)]; })
+  #define dispatch() \
+      __extension__ ({ ins = *++ip; goto *disptab[IGET_OP(ins)]; })
+#else
+  #define vm_exec_loop() \
+      loop: switch (IGET_OP(ins = *ip))
+  #define opcase(opc)           case OP_##opc
+  #define dispatch_current()    goto loop
+  #define dispatch()            do { ++ip; goto loop; } while (0)
+#endif
+
+
+/* the virtual machine registers are cached in the local variables
+ * of vm_exec(), the instruction pointer must be written back before
+ * calling any function that may raise an error or call a function */
+#define save_ip()               (vm->ip = ip)
+
+/* rewrite the current instruction with the specialized opcode, the
+ * code of constant (ROM) prototypes is never modified */
+#define quicken(op) \
+    if (!gc_isconst(clos->proto)) { \
+        *ip = (ins & ~IOP_MASK) | ISET_OP(op); \
+    }
+
+/* the guard of a quickened instruction failed: restore the generic
+ * opcode and execute the current instruction again */
+#define deoptimize(op) { \
+        *ip = (ins & ~IOP_MASK) | ISET_OP(op); \
+        dispatch_current(); \
+    }
+
+/* a fused relational instruction of two integers is quickened to
+ * OP_JCMPINT, the generic opcode is kept in the A operand */
+#define quicken_jcmp() \
+    if (var_isint(a) && var_isint(b) && !gc_isconst(clos->proto)) { \
+        *ip = IJCMP_QUICKEN(ins); \
+    }
+
+/* the inline cache entry of the current instruction if its attribute is
+ * a constant, ins_cache() returns NULL until the cache table is allocated */
+#define ins_cache(isk) \
+    ((isk) && clos->proto->mcache ? clos->proto->mcache + (ip - clos->proto->code) : NULL)
+#define slow_cache(isk) \
+    ((isk) ? member_cache(vm, clos->proto, (int)(ip - clos->proto->code)) : NULL)
+
+#if BE_USE_JIT
+/* count the entries and the loop back edges of the current function,
+ * and run its native code once the function is hot. 'n' is the offset
+ * of the next instruction from ip, and the native code returns the
+ * next instruction to be executed by the interpreter */
+#define jit_hotspot(n) { \
+        bproto *p = clos->proto; \
+        if (!gc_isconst(p) && !vm->budget && \
+            (p->jit || ++p->hotness == BE_JIT_HOT_COUNT)) { \
+            save_ip(); \
+            ip = be_jit_exec(vm, p, reg, ip + (n)) - (n); \
+        } \
+    }
+
+/* a call made by the native code returned, the function goes on in
+ * its native code without counting an entry */
+#define jit_resume() \
+    if (clos->proto->jit && !vm->budget) { \
+        save_ip(); \
+        ip = be_jit_exec(vm, clos->proto, reg, ip); \
+    }
+#else
+#define jit_hotspot(n)
+#define jit_resume()
+#endif
+
+/* charge one unit of the execution budget at a call or a loop back
+ * edge. the native code does not count the budget, so the JIT is not
+ * entered while a budget is set and the native code leaves to the
+ * interpreter at the back edges once one is set */
+#define budget_check() \
+    if (vm->budget && --vm->budget == 0) { \
+        save_ip(); \
+        budget_exhausted(vm); \
+        reg = vm->reg; \
+    }
+
+/* the function entries and the loop back edges are the safe points to
+ * call the finalizers queued by the GC, which may reallocate the stack */
+#define finalizer_check() \
+    if (be_gc_hasfinalizer(vm)) { \
+        save_ip(); \
+        be_gc_finalize(vm); \
+        reg = vm->reg; \
+    }
+
+#define RA()    (reg + IGET_RA(ins))
+#define RKB()   ((isKB(ins) ? ktab : reg) + KR2idx(IGET_RKB(ins)))
+#define RKC()   ((isKC(ins) ? ktab : reg) + KR2idx(IGET_RKC(ins)))
+
+/* the '.data' member of the builtin list and map instances */
+#define instance_data(v)    be_instance_members(cast(binstance*, var_toobj(v)))
 
 #define var2real(_v) \
-    (var_isreal(_v) ? (_v)->v.r : (breal)(_v)->v.i)
+    (var_isreal(_v) ? var_toreal(_v) : (breal)var_toint(_v))
 
 #define val2bool(v)        ((v) ? btrue : bfalse)
-#define ibinop(op, a, b)    ((a)->v.i op (b)->v.i)
+#define ibinop(op, a, b)    (var_toint(a) op var_toint(b))
+
+/* the method called by an instruction is either running as a new
+ * frame or has returned, resume_op() finishes the instruction in the
+ * latter case. both continue at newframe, which reloads the registers
+ * because the stack may be reallocated. */
+#define opcall_block(call) { \
+        if (!(call)) { \
+            resume_op(vm); \
+        } \
+        goto newframe; \
+    }
 
-#define define_function(name, block) \
-    static void name(bvm *vm, binstruction ins) { \
-        block \
+/* call the operator method 'om' of the instance `a` */
+#define object_binop_block(op, om) \
+    if (var_isinstance(a)) { \
+        save_ip(); \
+        opcall_block(object_binop(vm, om, a, b)) \
+    } else { \
+        save_ip(); \
+        binop_error(vm, op, a, b); \
     }
 
-#define relop_block(op) \
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins); \
+/* evaluate a relational expression into the `res` variable */
+#define relop_rule(op, om) \
+    int res; \
+    bvalue *a = RKB(), *b = RKC(); \
     if (var_isint(a) && var_isint(b)) { \
-        var_setbool(dst, ibinop(op, a, b)); \
+        res = ibinop(op, a, b); \
     } else if (var_isnumber(a) && var_isnumber(b)) { \
         breal x = var2real(a), y = var2real(b); \
-        var_setbool(dst, x op y); \
+        res = x op y; \
     } else if (var_isstr(a) && var_isstr(b)) { \
         bstring *s1 = var_tostr(a), *s2 = var_tostr(b); \
-        int res = be_strcmp(s1, s2); \
-        var_setbool(dst, res op 0); \
+        res = be_strcmp(s1, s2) op 0; \
     } else if (var_isinstance(a)) { \
-        binstance *obj = var_toobj(a); \
-        object_binop(vm, #op, ins, a, b); \
-        check_bool(vm, obj, #op); \
+        save_ip(); \
+        opcall_block(object_binop(vm, om, a, b)) \
     } else { \
+        save_ip(); \
         binop_error(vm, #op, a, b); \
+        res = 0; \
     }
 
-#define equal_block(op) \
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins); \
+#define equal_rule(op, iseq, om) \
+    int res; \
+    bvalue *a = RKB(), *b = RKC(); \
     if (var_isint(a) && var_isint(b)) { \
-        var_setbool(dst, ibinop(op, a, b)); \
+        res = ibinop(op, a, b); \
     } else if (var_isnumber(a) && var_isnumber(b)) { \
         breal x = var2real(a), y = var2real(b); \
-        var_setbool(dst, x op y); \
+        res = x op y; \
     } else if (var_type(a) == var_type(b)) { /* same types */ \
         if (var_isnil(a)) { /* nil op nil */\
-            var_setbool(dst, 1 op 1); \
+            res = 1 op 1; \
         } else if (var_isbool(a)) { /* bool op bool */ \
-            var_setbool(dst, var_tobool(a) op var_tobool(b)); \
+            res = var_tobool(a) op var_tobool(b); \
         } else if (var_isstr(a)) { /* string op string */ \
-            var_setbool(dst, 1 op be_eqstr(a->v.s, b->v.s)); \
+            res = 1 op be_eqstr(var_tostr(a), var_tostr(b)); \
         } else if (var_isclass(a) || var_isfunction(a)) { \
-            var_setbool(dst, var_toobj(a) op var_toobj(b)); \
+            res = var_toobj(a) op var_toobj(b); \
         } else if (var_isinstance(a)) { \
-            object_eqop(vm, #op, ins, a, b); \
+            save_ip(); \
+            opcall_block(object_eqop(vm, om, iseq, a, b)) \
         } else { \
+            save_ip(); \
             binop_error(vm, #op, a, b); \
+            res = 0; \
         } \
     } else { /* different types */ \
-        var_setbool(dst, 1 op 0); \
+        res = 1 op 0; \
     }
 
-#define bitwise_block(op) \
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins); \
+/* the fused relational instruction is always followed by a jump
+ * instruction, which is executed only when the result equals R(A) */
+#define relop_jump() \
+    if (res == (int)IGET_RA(ins)) { \
+        ip += IGET_sBx(ip[1]) + 1; /* take the jump */ \
+    } else { \
+        ++ip; /* skip the jump */ \
+    }
+
+#define bitwise_block(op, om) \
+    bvalue *dst = RA(), *a = RKB(), *b = RKC(); \
     if (var_isint(a) && var_isint(b)) { \
         var_setint(dst, ibinop(op, a, b)); \
-    } else if (var_isinstance(a)) { \
-        object_binop(vm, #op, ins, a, b); \
     } else { \
-        binop_error(vm, #op, a, b); \
+        object_binop_block(#op, om) \
     }
 
 #define push_native(_vm, _f, _ns, _t) { \
@@ -121,6 +255,18 @@ static void call_error(bvm *vm, bvalue *v)
     vm_error(vm, "'%s' value is not callable", be_vtype2str(v));
 }
 
+/* the hook may set a new budget to continue, or leave the VM by raising
+ * an error (e.g. be_pusherror) or with be_exit */
+static void budget_exhausted(bvm *vm)
+{
+    if (vm->budgethook) {
+        vm->budgethook(vm);
+    }
+    if (!vm->budget) {
+        vm_error(vm, "execution budget exhausted");
+    }
+}
+
 static void check_bool(bvm *vm, binstance *obj, const char *method)
 {
     if (!var_isbool(vm->top)) {
@@ -131,6 +277,15 @@ static void check_bool(bvm *vm, binstance *obj, const char *method)
     }
 }
 
+static void callstack_grow(bvm *vm)
+{
+    int size = vm->callsize * 2;
+    vm->callstack = be_realloc(vm, vm->callstack,
+        sizeof(bcallframe) * vm->callsize, sizeof(bcallframe) * size);
+    vm->callsize = size;
+    vm->cf = vm->calldepth ? be_callframe(vm, vm->calldepth - 1) : NULL;
+}
+
 static void precall(bvm *vm, bvalue *func, int nstack, int mode)
 {
     bcallframe *cf;
@@ -140,8 +295,10 @@ static void precall(bvm *vm, bvalue *func, int nstack, int mode)
         be_stack_expansion(vm, expan);
         func = vm->stack + fpos;
     }
-    be_stack_push(vm, &vm->callstack, NULL);
-    cf = be_stack_top(&vm->callstack);
+    if (vm->calldepth >= vm->callsize) {
+        callstack_grow(vm);
+    }
+    cf = be_callframe(vm, vm->calldepth++);
     cf->func = func - mode;
     cf->top = vm->top;
     cf->reg = vm->reg;
@@ -159,21 +316,40 @@ static void push_closure(bvm *vm, bvalue *func, int nstack, int mode)
     vm->ip = cl->proto->code;
 }
 
+/* call the closure func in the tail position of the current function,
+ * the call frame and the stack of the current function are reused */
+static void tail_call(bvm *vm, bvalue *func, int argc)
+{
+    bcallframe *cf = vm->cf;
+    bclosure *cl = var_toobj(func);
+    int i, expan = cl->proto->nstack + BE_STACK_FREE_MIN;
+    be_upvals_close(vm, vm->reg);
+    if (vm->stacktop < vm->reg + expan) {
+        size_t fpos = func - vm->stack;
+        be_stack_expansion(vm, expan);
+        func = vm->stack + fpos;
+    }
+    *cf->func = *func; /* the callee closure of the frame */
+    for (i = 0; i < argc; ++i) { /* move the arguments down */
+        vm->reg[i] = func[i + 1];
+    }
+    vm->top = vm->reg + cl->proto->nstack;
+    vm->ip = cl->proto->code;
+}
+
 static void ret_native(bvm *vm)
 {
     bcallframe *_cf = vm->cf;
     vm->reg = _cf->reg;
     vm->top = _cf->top;
-    be_stack_pop(&vm->callstack);
-    vm->cf = be_stack_top(&vm->callstack);
+    vm->cf = --vm->calldepth ? _cf - 1 : NULL;
 }
 
 static bbool obj2bool(bvm *vm, bvalue *var)
 {
     binstance *obj = var_toobj(var);
-    bstring *tobool = be_newstr(vm, "tobool");
     /* get operator method */
-    if (be_instance_member(obj, tobool, vm->top)) {
+    if (be_instance_opmethod(vm, obj, OM_TOBOOL, vm->top)) {
         vm->top[1] = *var; /* move self to argv[0] */
         be_dofunc(vm, vm->top, 1); /* call method 'tobool' */
         /* check the return value */
@@ -191,9 +367,9 @@ bbool be_value2bool(bvm *vm, bvalue *v)
     case BE_BOOL:
         return var_tobool(v);
     case BE_INT:
-        return val2bool(v->v.i);
+        return val2bool(var_toint(v));
     case BE_REAL:
-        return val2bool(v->v.r);
+        return val2bool(var_toreal(v));
     case BE_INSTANCE:
         return obj2bool(vm, v);
     default:
@@ -201,540 +377,452 @@ bbool be_value2bool(bvm *vm, bvalue *v)
     }
 }
 
-static void obj_method(bvm *vm, bvalue *o, bstring *attr)
+static void obj_method(bvm *vm, bvalue *o, int om)
 {
     binstance *obj = var_toobj(o);
-    int type = be_instance_member(obj, attr, vm->top);
+    int type = be_instance_opmethod(vm, obj, om, vm->top);
     if (basetype(type) != BE_FUNCTION) {
         vm_error(vm,
             "the '%s' object has no method '%s'",
-            str(be_instance_name(obj)), str(attr));
-    }
-}
-
-static int obj_attribute(bvm *vm, bvalue *o, bstring *attr, bvalue *dst)
-{
-    binstance *obj = var_toobj(o);
-    int type = be_instance_member(obj, attr, dst);
-    if (basetype(type) == BE_NIL) {
-        vm_error(vm,
-            "the '%s' object has no attribute '%s'",
-            str(be_instance_name(obj)), str(attr));
+            str(be_instance_name(obj)), str(vm->opnames[om]));
     }
-    return type;
 }
 
-static void object_eqop(bvm *vm,
-    const char *op, binstruction ins, bvalue *a, bvalue *b)
+/* call the method 'om' of o without arguments, the result is at
+ * vm->top. return 0 when o has no such method. */
+static int call_method(bvm *vm, bvalue *o, int om)
 {
-    binstance *obj = var_toobj(a);
-    /* get operator method */
-    int type = be_instance_member(obj, be_newstr(vm, op), vm->top);
-    if (basetype(type) == BE_FUNCTION) { /* call method */
+    if (var_isinstance(o)) {
         bvalue *top = vm->top;
-        top[1] = *a; /* move self to argv[0] */
-        top[2] = *b; /* move other to argv[1] */
-        be_incrtop(vm); /* prevent collection results */
-        be_dofunc(vm, top, 2); /* call method 'item' */
-        be_stackpop(vm, 1);
-        *RA(ins) = *vm->top; /* copy result to dst */
-        check_bool(vm, obj, op); /* check return value */
-    } else { /* default implementation */
-        int opt = IGET_OP(ins) == OP_EQ; /* operator is '==' */
-        int eqv = var_toobj(a) == var_toobj(b); /* are the same object */
-        /* if the operator is the '==', the expression is equivalent to:
-         *     RA(ins) = address(a) == address(b)
-         * else the operator is the '!=', the expression is equivalent to:
-         *     RA(ins) = address(a) != address(b)
-         **/
-        var_setbool(RA(ins), opt == eqv);
+        binstance *obj = var_toobj(o);
+        int type = be_instance_opmethod(vm, obj, om, top);
+        if (basetype(type) == BE_FUNCTION) {
+            top[1] = *o; /* move self to argv[0] */
+            be_dofunc(vm, top, 1);
+            return 1;
+        }
     }
+    return 0;
 }
 
-static void object_binop(bvm *vm,
-    const char *op, binstruction ins, bvalue *a, bvalue *b)
+/* get the data of the builtin list and map instances, which are
+ * indexed and iterated without calling their methods */
+static bvalue* builtin_data(bvm *vm, bvalue *o)
 {
-    bvalue *top = vm->top;
-    /* get operator method */
-    obj_method(vm, a, be_newstr(vm, op));
-    top[1] = *a; /* move self to argv[0] */
-    top[2] = *b; /* move other to argv[1] */
-    be_incrtop(vm); /* prevent collection results */
-    be_dofunc(vm, top, 2); /* call method 'item' */
-    be_stackpop(vm, 1);
-    *RA(ins) = *vm->top; /* copy result to dst */
-}
-
-static void object_unop(bvm *vm,
-    const char *op, binstruction ins, bvalue *src)
-{
-    bvalue *top = vm->top;
-    /* get operator method */
-    obj_method(vm, src, be_newstr(vm, op));
-    top[1] = *src; /* move self to argv[0] */
-    be_dofunc(vm, top, 1); /* call method 'item' */
-    *RA(ins) = *vm->top; /* copy result to dst */
-}
-
-static void i_ldnil(bvm *vm, binstruction ins)
-{
-    var_setnil(RA(ins));
-}
-
-static void i_ldbool(bvm *vm, binstruction ins)
-{
-    bvalue *v = RA(ins);
-    var_setbool(v, IGET_RKB(ins));
-    if (IGET_RKC(ins)) { /* skip next instruction */
-        vm->ip++;
+    if (var_isinstance(o)) {
+        binstance *obj = var_toobj(o);
+        if (obj->class == vm->listclass || obj->class == vm->mapclass) {
+            bvalue *data = instance_data(o);
+            if (var_islist(data) || var_ismap(data)) {
+                return data;
+            }
+        }
     }
+    return NULL;
 }
 
-static void i_ldint(bvm *vm, binstruction ins)
-{
-    bvalue *v = RA(ins);
-    var_setint(v, IGET_sBx(ins));
-}
-
-static void i_getglobal(bvm *vm, binstruction ins)
-{
-    bvalue *v = RA(ins);
-    int idx = IGET_Bx(ins);
-    *v = *be_global_var(vm, idx);
-}
-
-static void i_setglobal(bvm *vm, binstruction ins)
-{
-    bvalue *v = RA(ins);
-    int idx = IGET_Bx(ins);
-    *be_global_var(vm, idx) = *v;
-}
-
-static void i_getupval(bvm *vm, binstruction ins)
-{
-    bvalue *v = RA(ins);
-    int idx = IGET_Bx(ins);
-    *v = *curcl(vm)->upvals[idx]->value;
-}
-
-static void i_setupval(bvm *vm, binstruction ins)
-{
-    bvalue *v = RA(ins);
-    int idx = IGET_Bx(ins);
-    *curcl(vm)->upvals[idx]->value = *v;
-}
-
-static void i_ldconst(bvm *vm, binstruction ins)
-{
-    bvalue *dst = RA(ins);
-    *dst = curcl(vm)->proto->ktab[IGET_Bx(ins)];
-}
-
-static void i_move(bvm *vm, binstruction ins)
-{
-    bvalue *dst = RA(ins);
-    *dst = *RKB(ins);
-}
-
-static void i_add(bvm *vm, binstruction ins)
+/* the inline part of the builtin function 'fn' called by OP_INTRIN,
+ * return 0 when the argument must be handled by the real function */
+static int intrinsic(bvm *vm, int fn, bvalue *arg, bvalue *dst)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins);
-    if (var_isint(a) && var_isint(b)) {
-        var_setint(dst, ibinop(+, a, b));
-    } else if (var_isnumber(a) && var_isnumber(b)) {
-        breal x = var2real(a), y = var2real(b);
-        var_setreal(dst, x + y);
-    } else if (var_isstr(a) && var_isstr(b)) { /* strcat */
-        bstring *s = be_strcat(vm, var_tostr(a), var_tostr(b));
-        var_setstr(dst, s);
-    } else if (var_isinstance(a)) {
-        object_binop(vm, "+", ins, a, b);
-    } else {
-        binop_error(vm, "+", a, b);
+    switch (fn) {
+    case INTRIN_SIZE: {
+        bvalue *data = builtin_data(vm, arg);
+        if (var_isstr(arg)) {
+            var_setint(dst, str_len(var_tostr(arg)));
+        } else if (data && var_islist(data)) {
+            var_setint(dst, be_list_count(cast(blist*, var_toobj(data))));
+        } else if (data) {
+            var_setint(dst, be_map_count(cast(bmap*, var_toobj(data))));
+        } else {
+            return 0;
+        }
+        return 1;
+    }
+    case INTRIN_TYPE:
+        var_setstr(dst, be_newstr(vm, be_vtype2str(arg)));
+        return 1;
+    case INTRIN_STR:
+        if (var_isstr(arg)) {
+            *dst = *arg;
+        } else if (var_isnumber(arg)) {
+            var_setstr(dst, be_num2str(vm, arg));
+        } else {
+            return 0;
+        }
+        return 1;
+    case INTRIN_INT:
+        if (var_isint(arg)) {
+            *dst = *arg;
+        } else if (var_isreal(arg)) {
+            var_setint(dst, cast(bint, var_toreal(arg)));
+        } else {
+            return 0;
+        }
+        return 1;
+    case INTRIN_REAL:
+        if (var_isreal(arg)) {
+            *dst = *arg;
+        } else if (var_isint(arg)) {
+            var_setreal(dst, cast(breal, var_toint(arg)));
+        } else {
+            return 0;
+        }
+        return 1;
+    default:
+        return 0;
     }
 }
 
-static void i_sub(bvm *vm, binstruction ins)
+/* read data[k] of the builtin list or map instance. return 0 when the
+ * key must be handled by the method 'item' */
+static int builtin_getidx(bvalue *data, bvalue *k, bvalue *dst)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins);
-    if (var_isint(a) && var_isint(b)) {
-        var_setint(dst, ibinop(-, a, b));
-    } else if (var_isnumber(a) && var_isnumber(b)) {
-        breal x = var2real(a), y = var2real(b);
-        var_setreal(dst, x - y);
-    } else if (var_isinstance(a)) {
-        object_binop(vm, "-", ins, a, b);
+    bvalue *src = NULL;
+    if (var_islist(data)) {
+        if (!var_isint(k)) { /* index by range or list */
+            return 0;
+        }
+        src = be_list_index(var_toobj(data), var_toidx(k));
+    } else if (!var_isnil(k)) {
+        src = be_map_find(var_toobj(data), k);
+    }
+    if (src) {
+        var_setval(dst, src);
     } else {
-        binop_error(vm, "-", a, b);
+        var_setnil(dst);
     }
+    return 1;
 }
 
-static void i_mul(bvm *vm, binstruction ins)
+/* update an existing element of the builtin list or map instance */
+static void builtin_setidx(bvm *vm, bvalue *data, bvalue *k, bvalue *src)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins);
-    if (var_isint(a) && var_isint(b)) {
-        var_setint(dst, ibinop(*, a, b));
-    } else if (var_isnumber(a) && var_isnumber(b)) {
-        breal x = var2real(a), y = var2real(b);
-        var_setreal(dst, x * y);
-    } else if (var_isinstance(a)) {
-        object_binop(vm, "*", ins, a, b);
-    } else {
-        binop_error(vm, "*", a, b);
+    bvalue *dst = NULL;
+    if (var_islist(data)) {
+        if (var_isint(k)) {
+            dst = be_list_index(var_toobj(data), var_toidx(k));
+        }
+    } else if (!var_isnil(k)) {
+        dst = be_map_find(var_toobj(data), k);
+    }
+    if (dst) {
+        be_gc_barrier(vm, gc_object(var_toobj(data)));
+        var_setval(dst, src);
     }
 }
 
-static void i_div(bvm *vm, binstruction ins)
+/* iterate the list or map data, the index of the last element is
+ * kept in *iter. return NULL at the end of the iteration. */
+static bvalue* iter_next(bvalue *data, bvalue *iter)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins);
-    if (var_isint(a) && var_isint(b)) {
-        bint x = var_toint(a), y = var_toint(b);
-        if (y == 0) {
-            vm_error(vm, "division by zero");
-        }
-        var_setint(dst, x / y);
-    } else if (var_isnumber(a) && var_isnumber(b)) {
-        breal x = var2real(a), y = var2real(b);
-        if (y == cast(breal, 0)) {
-            vm_error(vm, "division by zero");
+    bint i = var_toint(iter) + 1;
+    if (var_islist(data)) {
+        blist *list = var_toobj(data);
+        if (i < be_list_count(list)) {
+            var_setint(iter, i);
+            return be_list_at(list, i);
         }
-        var_setreal(dst, x / y);
-    } else if (var_isinstance(a)) {
-        object_binop(vm, "/", ins, a, b);
     } else {
-        binop_error(vm, "/", a, b);
+        bmap *map = var_toobj(data);
+        if (i < be_map_size(map)) {
+            bmapiter node = i ? map->slots + i - 1 : be_map_iter();
+            if (be_map_next(map, &node)) {
+                var_setint(iter, node - map->slots);
+                return &node->value;
+            }
+        }
     }
+    return NULL;
 }
 
-static void i_mod(bvm *vm, binstruction ins)
+/* get the inline cache entry of the instruction at 'pc', the cache
+ * table has an entry per instruction and is allocated at the first
+ * lookup */
+static bmcache* member_cache(bvm *vm, bproto *proto, int pc)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins), *b = RKC(ins);
-    if (var_isint(a) && var_isint(b)) {
-        var_setint(dst, ibinop(%, a, b));
-    } else if (var_isinstance(a)) {
-        object_binop(vm, "%", ins, a, b);
-    } else {
-        binop_error(vm, "%", a, b);
+    if (proto->mcache == NULL) {
+        int i, count = proto->codesize;
+        if (gc_isconst(proto)) { /* the prototype is read-only */
+            return NULL;
+        }
+        proto->mcache = be_malloc(vm, sizeof(bmcache) * count);
+        for (i = 0; i < count; ++i) {
+            proto->mcache[i].owner = NULL;
+        }
     }
+    be_gc_barrier(vm, proto); /* the caller will update the entry */
+    return proto->mcache + pc;
 }
 
-static void i_neg(bvm *vm, binstruction ins)
+/* get the instance owning the member of the cache entry, the result is
+ * NULL if the entry does not match. the entry is out of date once a
+ * class of the chain up to the owner of the member has been modified
+ * (e.g. by be_class_setsuper()), see be_class_version() */
+static binstance* cache_lookup(bmcache *mc, binstance *obj)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins);
-    if (var_isint(a)) {
-        var_setint(dst, -a->v.i);
-    } else if (var_isreal(a)) {
-        var_setreal(dst, -a->v.r);
-    } else if (var_isinstance(a)) {
-        object_unop(vm, "-*", ins, a);
-    } else {
-        unop_error(vm, "-", a);
+    if (mc && mc->owner == gc_object(obj->class)) {
+        bclass *c = obj->class;
+        int depth = mc->depth;
+        while (c->version <= mc->version) {
+            if (depth-- == 0) {
+                return obj;
+            }
+            obj = obj->super; /* as be_instance_base() */
+            c = c->super;
+            if (obj == NULL || obj->class != c) {
+                return NULL;
+            }
+        }
     }
+    return NULL;
 }
 
-static void i_flip(bvm *vm, binstruction ins)
+/* read the member of the cache entry from the instance owning it */
+static int cache_member(bmcache *mc, binstance *obj, bvalue *dst)
 {
-    bvalue *dst = RA(ins), *a = RKB(ins);
-    if (var_isint(a)) {
-        var_setint(dst, -a->v.i);
-    } else if (var_isinstance(a)) {
-        object_unop(vm, "~", ins, a);
+    int type = var_type(&mc->value);
+    if (type == MT_VARIABLE) {
+        *dst = obj->members[var_toint(&mc->value)];
     } else {
-        unop_error(vm, "~", a);
+        *dst = mc->value;
     }
+    return type;
 }
 
-define_function(i_lt, relop_block(<))
-define_function(i_le, relop_block(<=))
-define_function(i_gt, relop_block(>))
-define_function(i_ge, relop_block(>=))
-define_function(i_eq, equal_block(==))
-define_function(i_ne, equal_block(!=))
-define_function(i_and, bitwise_block(&))
-define_function(i_or, bitwise_block(|))
-define_function(i_xor, bitwise_block(^))
-define_function(i_shl, bitwise_block(<<))
-define_function(i_shr, bitwise_block(>>))
-
-static void i_range(bvm *vm, binstruction ins)
-{
-    bvalue *b = RKB(ins), *c = RKC(ins);
-    bvalue *top = vm->top;
-    /* get method 'item' */
-    int idx = be_builtin_find(vm, be_newstr(vm, "range"));
-    top[0] = *be_global_var(vm, idx);
-    top[1] = *b; /* move lower to argv[0] */
-    top[2] = *c; /* move upper to argv[1] */
-    vm->top += 3; /* prevent collection results */
-    be_dofunc(vm, top, 2); /* call method 'item' */
-    vm->top -= 3;
-    *RA(ins) = *vm->top; /* copy result to R(A) */
-}
-
-static void i_jump(bvm *vm, binstruction ins)
-{
-    vm->ip += IGET_sBx(ins);
-}
-
-static void i_jumptrue(bvm *vm, binstruction ins)
+static int obj_attribute(bvm *vm,
+    bmcache *mc, bvalue *o, bstring *attr, bvalue *dst)
 {
-    if (be_value2bool(vm, RA(ins))) {
-        vm->ip += IGET_sBx(ins);
+    bmcache temp;
+    binstance *obj = var_toobj(o), *base = NULL;
+    bvalue member;
+    int depth = be_class_member(obj->class, attr, &member);
+    if (depth >= 0) {
+        base = be_instance_base(obj, depth);
     }
-}
-
-static void i_jumpfalse(bvm *vm, binstruction ins)
-{
-    if (!be_value2bool(vm, RA(ins))) {
-        vm->ip += IGET_sBx(ins);
+    if (base == NULL) { /* not found, or the instance has an old chain */
+        int type = be_instance_member(obj, attr, dst);
+        if (type == BE_NIL) {
+            vm_error(vm,
+                "the '%s' object has no attribute '%s'",
+                str(be_instance_name(obj)), str(attr));
+        }
+        return type;
     }
-}
-
-static void i_return(bvm *vm, binstruction ins)
-{
-    bcallframe *cf = vm->cf;
-    bvalue *ret = vm->cf->func;
-    /* copy return value */
-    if (IGET_RA(ins)) {
-        *ret = *RKB(ins);
-    } else {
-        var_setnil(ret);
-    }
-    vm->reg = cf->reg;
-    vm->top = cf->top;
-    vm->ip = cf->ip;
-    be_stack_pop(&vm->callstack); /* pop don't delete */
-    if (cf->status & BASE_FRAME) { /* entrance function */
-        vm->cf = NULL; /* mainfunction return */
-    } else {
-        vm->cf = be_stack_top(&vm->callstack);
+    if (mc == NULL) { /* the attribute is not cacheable */
+        mc = &temp;
     }
+    mc->owner = gc_object(obj->class);
+    mc->value = member;
+    mc->depth = depth;
+    mc->version = be_class_version(obj->class, depth);
+    return cache_member(mc, base, dst);
 }
 
-static void i_call(bvm *vm, binstruction ins)
+/* call the method at vm->top with the arguments vm->top[1..argc] for
+ * the current instruction. a closure is pushed as a new frame of the
+ * running vm_exec() loop and the result is 1, the instruction will be
+ * finished by resume_op() when the frame returns. other functions are
+ * called immediately and the result is 0. */
+static int opcall(bvm *vm, int argc)
 {
-    bvalue *var = RA(ins);
-    int mode = 0, argc = IGET_RKB(ins);
-
-    recall: /* goto: instantiation class and call constructor */
-    switch (var_type(var)) {
-    case NOT_METHOD:
-        ++var; --argc; mode = 1;
-        goto recall;
-    case BE_CLASS:
-        if (be_class_newobj(vm, var_toobj(var), var, ++argc)) {
-            ++var; /* to next register */
-            goto recall; /* call constructor */
-        }
-        ++vm->ip; /* to next instruction */
-        break;
-    case BE_CLOSURE: {
+    bvalue *top = vm->top;
+    if (var_isclosure(top)) {
         bvalue *v, *end;
-        bproto *proto = var2cl(var)->proto;
-        push_closure(vm, var, proto->nstack, mode);
+        bproto *proto = var2cl(top)->proto;
+        push_closure(vm, top, proto->nstack, 0);
+        vm->cf->status = RESUME_FRAME;
         v = vm->reg + argc;
         end = vm->reg + proto->argc;
         for (; v <= end; ++v) {
             var_setnil(v);
         }
-        break;
-    }
-    case BE_NTVCLOS: {
-        bntvclos *f = var_toobj(var);
-        push_native(vm, var, argc, mode);
-        f->f(vm); /* call C primitive function */
-        ret_native(vm);
-        ++vm->ip; /* to next instruction */
-        break;
-    }
-    case BE_NTVFUNC: {
-        bntvfunc f = var_tontvfunc(var);
-        push_native(vm, var, argc, mode);
-        f(vm); /* call C primitive function */
-        ret_native(vm);
-        ++vm->ip; /* to next instruction */
-        break;
-    }
-    default:
-        call_error(vm, var);
+        return 1;
     }
+    vm->top += argc + 1; /* prevent collection arguments */
+    be_dofunc(vm, top, argc);
+    vm->top -= argc + 1;
+    return 0;
 }
 
-static void i_closure(bvm *vm, binstruction ins)
+static int object_eqop(bvm *vm,
+    int om, int iseq, bvalue *a, bvalue *b)
 {
-    bvalue *reg = RA(ins);
-    bproto *p = curcl(vm)->proto->ptab[IGET_Bx(ins)];
-    bclosure *cl = be_newclosure(vm, p->nupvals);
-    cl->proto = p;
-    var_setclosure(reg, cl);
-    be_initupvals(vm, cl);
-}
-
-static void i_getmember(bvm *vm, binstruction ins)
-{
-    bvalue *a = RA(ins), *b = RKB(ins), *c = RKC(ins);
-    if (var_isinstance(b) && var_isstr(c)) {
-        obj_attribute(vm, b, var_tostr(c), a);
-    } else if (var_ismodule(b) && var_isstr(c)) {
-        bstring *attr = var_tostr(c);
-        bmodule *module = var_toobj(b);
-        bvalue *v = be_module_attr(module, attr);
-        if (v) {
-            *a = *v;
-        } else {
-            vm_error(vm, "module '%s' has no attribute '%s'",
-                be_module_name(module), str(attr));
-        }
-    } else {
-        attribute_error(vm, "attribute", b, c);
+    binstance *obj = var_toobj(a);
+    /* get operator method */
+    int type = be_instance_opmethod(vm, obj, om, vm->top);
+    if (basetype(type) == BE_FUNCTION) { /* call method */
+        bvalue *top = vm->top;
+        top[1] = *a; /* move self to argv[0] */
+        top[2] = *b; /* move other to argv[1] */
+        return opcall(vm, 2);
+    } else { /* default implementation */
+        int eqv = var_toobj(a) == var_toobj(b); /* are the same object */
+        /* if the operator is the '==', the expression is equivalent to:
+         *     result = address(a) == address(b)
+         * else the operator is the '!=', the expression is equivalent to:
+         *     result = address(a) != address(b)
+         **/
+        var_setbool(vm->top, iseq == eqv);
     }
+    return 0;
 }
 
-static void i_getmethod(bvm *vm, binstruction ins)
+/* call the operator method of the instance a, see opcall() */
+static int object_binop(bvm *vm, int om, bvalue *a, bvalue *b)
 {
-    bvalue *a = RA(ins), *b = RKB(ins), *c = RKC(ins);
-    if (var_isinstance(b) && var_isstr(c)) {
-        bvalue self = *b;
-        bstring *attr = var_tostr(c);
-        binstance *obj = var_toobj(b);
-        int type = obj_attribute(vm, b, var_tostr(c), a);
-        if (type == MT_METHOD || type == MT_PRIMMETHOD) {
-            a[1] = self;
-        } else if (var_basetype(a) == BE_FUNCTION) {
-            a[1] = *a;
-            var_settype(a, NOT_METHOD);
-        } else {
-            vm_error(vm, "class '%s' has no method '%s'",
-                str(be_instance_name(obj)), str(attr));
-        }
-    } else if (var_ismodule(b) && var_isstr(c)) {
-        bstring *attr = var_tostr(c);
-        bmodule *module = var_toobj(b);
-        bvalue *src = be_module_attr(module, attr);
-        if (src) {
-            var_settype(a, NOT_METHOD);
-            a[1] = *src;
-        } else {
-            vm_error(vm, "module '%s' has no method '%s'",
-                be_module_name(module), str(attr));
-        }
-    } else {
-        attribute_error(vm, "method", b, c);
-    }
+    bvalue *top = vm->top;
+    /* get operator method */
+    obj_method(vm, a, om);
+    top[1] = *a; /* move self to argv[0] */
+    top[2] = *b; /* move other to argv[1] */
+    return opcall(vm, 2);
 }
 
-static void i_setmember(bvm *vm, binstruction ins)
+static int object_unop(bvm *vm, int om, bvalue *src)
 {
-    bvalue *a = RA(ins), *b = RKB(ins), *c = RKC(ins);
-    if (var_isinstance(a) && var_isstr(b)) {
-        binstance *obj = var_toobj(a);
-        bstring *attr = var_tostr(b);
-        if (!be_instance_setmember(obj, attr, c)) {
-            vm_error(vm, "class '%s' cannot assign to attribute '%s'",
-                str(be_instance_name(obj)), str(attr));
-        }
-    } else {
-        attribute_error(vm, "writable attribute", a, b);
-    }
+    bvalue *top = vm->top;
+    /* get operator method */
+    obj_method(vm, src, om);
+    top[1] = *src; /* move self to argv[0] */
+    return opcall(vm, 1);
 }
 
-static void i_getindex(bvm *vm, binstruction ins)
+static int object_setidx(bvm *vm, bvalue *a, bvalue *b, bvalue *c)
 {
-    bvalue *b = RKB(ins), *c = RKC(ins);
-    if (var_isinstance(b)) {
-        bvalue *top = vm->top;
-        /* get method 'item' */
-        obj_method(vm, b, be_newstr(vm, "item"));
-        top[1] = *b; /* move object to argv[0] */
-        top[2] = *c; /* move key to argv[1] */
-        vm->top += 3;   /* prevent collection results */
-        be_dofunc(vm, top, 2); /* call method 'item' */
-        vm->top -= 3;
-        *RA(ins) = *vm->top;   /* copy result to R(A) */
-    } else if (var_isstr(b)) {
-        bstring *s = be_strindex(vm, var_tostr(b), c);
-        var_setstr(RA(ins), s);
-    } else {
-        vm_error(vm,
-            "value '%s' does not support subscriptable",
-            be_vtype2str(b));
-    }
+    bvalue *top = vm->top;
+    /* get method 'setitem' */
+    obj_method(vm, a, OM_SETITEM);
+    top[1] = *a; /* move object to argv[0] */
+    top[2] = *b; /* move key to argv[1] */
+    top[3] = *c; /* move src to argv[2] */
+    return opcall(vm, 3);
 }
 
-static void i_setindex(bvm *vm, binstruction ins)
+/* call the method 'tobool' of the instance v, the result is true
+ * without the method */
+static int object_tobool(bvm *vm, bvalue *v)
 {
-    bvalue *a = RA(ins), *b = RKB(ins), *c = RKC(ins);
-    if (var_isinstance(a)) {
-        bvalue *top = vm->top;
-        /* get method 'setitem' */
-        obj_method(vm, a, be_newstr(vm, "setitem"));
-        top[1] = *a; /* move object to argv[0] */
-        top[2] = *b; /* move key to argv[1] */
-        top[3] = *c; /* move src to argv[2] */
-        vm->top += 4;
-        be_dofunc(vm, top, 3); /* call method 'setitem' */
-        vm->top -= 4;
-    } else {
-        vm_error(vm,
-            "value '%s' does not support index assignment",
-            be_vtype2str(a));
+    binstance *obj = var_toobj(v);
+    bvalue *top = vm->top;
+    if (be_instance_opmethod(vm, obj, OM_TOBOOL, top)) {
+        top[1] = *v; /* move self to argv[0] */
+        return opcall(vm, 1);
     }
+    var_setbool(top, btrue);
+    return 0;
 }
 
-static void i_setsuper(bvm *vm, binstruction ins)
+static const char* relop_name(int op)
 {
-    bvalue *a = RA(ins), *b = RKB(ins);
-    if (var_isclass(a) && var_isclass(b)) {
-        bclass *obj = var_toobj(a);
-        be_class_setsuper(obj, var_toobj(b));
-    } else {
-        vm_error(vm,
-            "value '%s' does not support set super",
-            be_vtype2str(b));
+    switch (op) {
+    case OP_LT: case OP_JLT: return "<";
+    case OP_LE: case OP_JLE: return "<=";
+    case OP_GT: case OP_JGT: return ">";
+    case OP_GE: case OP_JGE: return ">=";
+    case OP_EQ: case OP_JEQ: return "==";
+    default: return "!="; /* OP_NE and OP_JNE */
     }
 }
 
-static void i_close(bvm *vm, binstruction ins)
+/* the result of the method called by the instruction at vm->ip is at
+ * vm->top, finish the instruction and move vm->ip to the next one */
+static void resume_op(bvm *vm)
 {
-    be_upvals_close(vm, RA(ins));
+    binstruction *ip = vm->ip, ins = *ip;
+    bvalue *reg = vm->reg, *res = vm->top;
+    bvalue *ktab = cast(bclosure*, var_toobj(vm->cf->func))->proto->ktab;
+    bvalue *self = RKB();
+    int op = IGET_OP(ins);
+    switch (op) {
+    case OP_JMPT: case OP_JMPF: /* the method 'tobool' */
+        self = RA();
+        if (var_isinstance(self)) {
+            check_bool(vm, var_toobj(self), "tobool");
+        }
+        if (var_tobool(res) == (op == OP_JMPT)) {
+            ip += IGET_sBx(ins);
+        }
+        break;
+    case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+    case OP_EQ: case OP_NE:
+        if (var_isinstance(self)) {
+            check_bool(vm, var_toobj(self), relop_name(op));
+        }
+        *RA() = *res;
+        break;
+    case OP_JLT: case OP_JLE: case OP_JGT: case OP_JGE:
+    case OP_JEQ: case OP_JNE:
+        if (var_isinstance(self)) {
+            check_bool(vm, var_toobj(self), relop_name(op));
+        }
+        if ((int)var_tobool(res) == (int)IGET_RA(ins)) {
+            ip += IGET_sBx(ip[1]) + 1; /* take the jump */
+        } else {
+            ++ip; /* skip the jump */
+        }
+        break;
+    case OP_SETIDX: /* the result of 'setitem' is discarded */
+        break;
+    default: /* the binary or unary operators and OP_GETIDX */
+        *RA() = *res;
+        break;
+    }
+    vm->ip = ip + 1;
 }
 
-static void i_import(bvm *vm, binstruction ins)
+/* get the class registered as the builtin 'name', in the builtin table
+ * of the precompiled objects or of the libraries loaded at run time. the
+ * class is fixed since the VM keeps a pointer to it */
+static bclass* builtin_class(bvm *vm, const char *name)
 {
-    bvalue *dst = RA(ins), *b = RKB(ins);
-    if (var_isstr(b)) {
-        bmodule *m = be_module_load(vm, var_tostr(b), dst);
-        if (m == NULL) {
-            vm_error(vm, "module '%s' not found",
-                str(var_tostr(b)));
+    int idx = be_builtin_find(vm, be_newstr(vm, name));
+    if (idx >= 0) {
+        bvalue *v = be_global_var(vm, idx);
+        if (var_isclass(v)) {
+            be_gc_fix(vm, var_togc(v));
+            return var_toobj(v);
         }
-    } else {
-        vm_error(vm,
-            "import '%s' does not support import",
-            be_vtype2str(b));
     }
+    return NULL;
 }
 
 bvm* be_vm_new(void)
 {
     bvm *vm = be_os_malloc(sizeof(bvm));
     be_assert(vm != NULL);
+    be_mempool_init(vm);
     be_gc_init(vm);
     be_string_init(vm);
-    be_stack_init(vm, &vm->callstack, sizeof(bcallframe));
+    be_opmethod_init(vm);
+    vm->callstack = be_malloc(vm, sizeof(bcallframe) * CALLSTACK_INIT);
+    vm->callsize = CALLSTACK_INIT;
+    vm->calldepth = 0;
     be_stack_init(vm, &vm->refstack, sizeof(binstance*));
     vm->stack = be_malloc(vm, sizeof(bvalue) * BE_STACK_FREE_MIN);
     vm->stacktop = vm->stack + BE_STACK_FREE_MIN;
+    vm->upvaltab = be_malloc(vm, sizeof(bupval*) * BE_STACK_FREE_MIN);
+    memset(vm->upvaltab, 0, sizeof(bupval*) * BE_STACK_FREE_MIN);
+    vm->upvaltop = 0;
+    vm->stacklimit = BE_STACK_TOTAL_MAX;
+    vm->budget = 0;
+    vm->budgethook = NULL;
+#if BE_USE_JIT
+    vm->perfmap = NULL;
+#endif
     vm->cf = NULL;
     vm->ip = NULL;
-    vm->upvalist = NULL;
     vm->reg = vm->stack;
     vm->top = vm->reg;
     vm->errjmp = NULL;
     vm->modulelist = NULL;
+    vm->listclass = NULL;
+    vm->mapclass = NULL;
     be_globalvar_init(vm);
     be_gc_setpause(vm, 1);
     be_loadlibs(vm);
+    vm->listclass = builtin_class(vm, "list");
+    vm->mapclass = builtin_class(vm, "map");
     return vm;
 }
 
@@ -742,74 +830,870 @@ void be_vm_delete(bvm *vm)
 {
     be_gc_deleteall(vm);
     be_string_deleteall(vm);
-    be_stack_delete(vm, &vm->callstack);
+    be_free(vm, vm->callstack, sizeof(bcallframe) * vm->callsize);
     be_stack_delete(vm, &vm->refstack);
+    be_upvals_close(vm, vm->stack); /* free the remaining open upvalues */
+    be_free(vm, vm->upvaltab, (vm->stacktop - vm->stack) * sizeof(bupval*));
     be_free(vm, vm->stack, (vm->stacktop - vm->stack) * sizeof(bvalue));
     be_globalvar_deinit(vm);
+#if BE_USE_JIT
+    be_jit_delete(vm);
+#endif
+    be_mempool_delete(vm);
     be_os_free(vm);
 }
 
 static void vm_exec(bvm *vm)
 {
-    binstruction ins;
+    bclosure *clos;
+    bvalue *ktab, *reg;
+    binstruction ins, *ip;
+#if BE_USE_COMPUTED_GOTO
+    static const void *const disptab[] = {
+        #define OPCODE(opc) __extension__ &&L_##opc
+        #include "be_opcodes.h"
+        #undef OPCODE
+    };
+#endif
     vm->cf->status |= BASE_FRAME;
-    newframe:
-    for (;;) {
-        ins = *vm->ip;
-        switch (IGET_OP(ins)) {
-        case OP_LDNIL: i_ldnil(vm, ins); break;
-        case OP_LDBOOL: i_ldbool(vm, ins); break;
-        case OP_LDINT: i_ldint(vm, ins); break;
-        case OP_LDCONST: i_ldconst(vm, ins); break;
-        case OP_GETGBL: i_getglobal(vm, ins); break;
-        case OP_SETGBL: i_setglobal(vm, ins); break;
-        case OP_GETUPV: i_getupval(vm, ins); break;
-        case OP_SETUPV: i_setupval(vm, ins); break;
-        case OP_MOVE: i_move(vm, ins); break;
-        case OP_ADD: i_add(vm, ins); break;
-        case OP_SUB: i_sub(vm, ins); break;
-        case OP_MUL: i_mul(vm, ins); break;
-        case OP_DIV: i_div(vm, ins); break;
-        case OP_MOD: i_mod(vm, ins); break;
-        case OP_LT: i_lt(vm, ins); break;
-        case OP_LE: i_le(vm, ins); break;
-        case OP_EQ: i_eq(vm, ins); break;
-        case OP_NE: i_ne(vm, ins); break;
-        case OP_GT: i_gt(vm, ins); break;
-        case OP_GE: i_ge(vm, ins); break;
-        case OP_RANGE: i_range(vm, ins); break;
-        case OP_AND: i_and(vm, ins); break;
-        case OP_OR: i_or(vm, ins); break;
-        case OP_XOR: i_xor(vm, ins); break;
-        case OP_SHL: i_shl(vm, ins); break;
-        case OP_SHR: i_shr(vm, ins); break;
-        case OP_NEG: i_neg(vm, ins); break;
-        case OP_FLIP: i_flip(vm, ins); break;
-        case OP_JMP: i_jump(vm, ins); break;
-        case OP_JMPT: i_jumptrue(vm, ins); break;
-        case OP_JMPF: i_jumpfalse(vm, ins); break;
-        case OP_CALL: i_call(vm, ins); goto newframe;
-        case OP_CLOSURE: i_closure(vm, ins); break;
-        case OP_GETMBR: i_getmember(vm, ins); break;
-        case OP_GETMET: i_getmethod(vm, ins); break;
-        case OP_SETMBR: i_setmember(vm, ins); break;
-        case OP_GETIDX: i_getindex(vm, ins); break;
-        case OP_SETIDX: i_setindex(vm, ins); break;
-        case OP_SETSUPER: i_setsuper(vm, ins); break;
-        case OP_CLOSE: i_close(vm, ins); break;
-        case OP_IMPORT: i_import(vm, ins); break;
-        case OP_RET: i_return(vm, ins); goto retpoint;
-        default: retpoint:
-            if (vm->cf == NULL) {
-                bstack *cs = &vm->callstack;
-                if (!be_stack_isempty(cs)) {
-                    vm->cf = be_stack_top(cs);
+newframe: /* a new call frame */
+    be_assert(var_isclosure(vm->cf->func));
+    clos = var_toobj(vm->cf->func); /* the current closure */
+    ktab = clos->proto->ktab; /* the current constant table */
+    reg = vm->reg; /* the current stack base of the call frame */
+    ip = vm->ip;
+    finalizer_check();
+    if (ip == clos->proto->code) { /* only the calls are counted */
+        jit_hotspot(0);
+    } else {
+        jit_resume();
+    }
+    vm_exec_loop() {
+        opcase(LDNIL): {
+            var_setnil(RA());
+            dispatch();
+        }
+        opcase(LDBOOL): {
+            bvalue *v = RA();
+            var_setbool(v, IGET_RKB(ins));
+            if (IGET_RKC(ins)) { /* skip next instruction */
+                ++ip;
+            }
+            dispatch();
+        }
+        opcase(LDINT): {
+            bvalue *v = RA();
+            var_setint(v, IGET_sBx(ins));
+            dispatch();
+        }
+        opcase(LDCONST): {
+            bvalue *dst = RA();
+            *dst = ktab[IGET_Bx(ins)];
+            dispatch();
+        }
+        opcase(GETGBL): {
+            bvalue *v = RA();
+            int idx = IGET_Bx(ins);
+            *v = *be_global_var(vm, idx);
+            dispatch();
+        }
+        opcase(SETGBL): {
+            bvalue *v = RA();
+            int idx = IGET_Bx(ins);
+            *be_global_var(vm, idx) = *v;
+            dispatch();
+        }
+        opcase(GETUPV): {
+            bvalue *v = RA();
+            int idx = IGET_Bx(ins);
+            *v = *clos->upvals[idx]->value;
+            dispatch();
+        }
+        opcase(SETUPV): {
+            bvalue *v = RA();
+            int idx = IGET_Bx(ins);
+            be_gc_barrierval(vm, v);
+            *clos->upvals[idx]->value = *v;
+            dispatch();
+        }
+        opcase(MOVE): {
+            bvalue *dst = RA();
+            *dst = *RKB();
+            dispatch();
+        }
+        opcase(ADD): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(+, a, b));
+                quicken(OP_ADDINT)
+            } else if (var_isnumber(a) && var_isnumber(b)) {
+                breal x = var2real(a), y = var2real(b);
+                var_setreal(dst, x + y);
+                if (var_isreal(a) && var_isreal(b)) {
+                    quicken(OP_ADDREAL)
+                }
+            } else if (var_isstr(a) && var_isstr(b)) { /* strcat */
+                bstring *s;
+                save_ip();
+                s = be_strcat(vm, var_tostr(a), var_tostr(b));
+                reg = vm->reg;
+                var_setstr(RA(), s);
+            } else {
+                object_binop_block("+", OM_ADD)
+            }
+            dispatch();
+        }
+        opcase(SUB): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(-, a, b));
+                quicken(OP_SUBINT)
+            } else if (var_isnumber(a) && var_isnumber(b)) {
+                breal x = var2real(a), y = var2real(b);
+                var_setreal(dst, x - y);
+                if (var_isreal(a) && var_isreal(b)) {
+                    quicken(OP_SUBREAL)
+                }
+            } else {
+                object_binop_block("-", OM_SUB)
+            }
+            dispatch();
+        }
+        opcase(MUL): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(*, a, b));
+                quicken(OP_MULINT)
+            } else if (var_isnumber(a) && var_isnumber(b)) {
+                breal x = var2real(a), y = var2real(b);
+                var_setreal(dst, x * y);
+                if (var_isreal(a) && var_isreal(b)) {
+                    quicken(OP_MULREAL)
+                }
+            } else {
+                object_binop_block("*", OM_MUL)
+            }
+            dispatch();
+        }
+        opcase(DIV): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                bint x = var_toint(a), y = var_toint(b);
+                if (y == 0) {
+                    save_ip();
+                    vm_error(vm, "division by zero");
+                }
+                var_setint(dst, x / y);
+                quicken(OP_DIVINT)
+            } else if (var_isnumber(a) && var_isnumber(b)) {
+                breal x = var2real(a), y = var2real(b);
+                if (y == cast(breal, 0)) {
+                    save_ip();
+                    vm_error(vm, "division by zero");
+                }
+                var_setreal(dst, x / y);
+                if (var_isreal(a) && var_isreal(b)) {
+                    quicken(OP_DIVREAL)
+                }
+            } else {
+                object_binop_block("/", OM_DIV)
+            }
+            dispatch();
+        }
+        opcase(MOD): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(%, a, b));
+            } else {
+                object_binop_block("%", OM_MOD)
+            }
+            dispatch();
+        }
+        opcase(LT): {
+            relop_rule(<, OM_LT)
+            var_setbool(RA(), res);
+            dispatch();
+        }
+        opcase(LE): {
+            relop_rule(<=, OM_LE)
+            var_setbool(RA(), res);
+            dispatch();
+        }
+        opcase(EQ): {
+            equal_rule(==, btrue, OM_EQ)
+            var_setbool(RA(), res);
+            dispatch();
+        }
+        opcase(NE): {
+            equal_rule(!=, bfalse, OM_NE)
+            var_setbool(RA(), res);
+            dispatch();
+        }
+        opcase(GT): {
+            relop_rule(>, OM_GT)
+            var_setbool(RA(), res);
+            dispatch();
+        }
+        opcase(GE): {
+            relop_rule(>=, OM_GE)
+            var_setbool(RA(), res);
+            dispatch();
+        }
+        opcase(AND): {
+            bitwise_block(&, OM_AND)
+            dispatch();
+        }
+        opcase(OR): {
+            bitwise_block(|, OM_OR)
+            dispatch();
+        }
+        opcase(XOR): {
+            bitwise_block(^, OM_XOR)
+            dispatch();
+        }
+        opcase(SHL): {
+            bitwise_block(<<, OM_SHL)
+            dispatch();
+        }
+        opcase(SHR): {
+            bitwise_block(>>, OM_SHR)
+            dispatch();
+        }
+        opcase(RANGE): {
+            bvalue *b = RKB(), *c = RKC();
+            bvalue *top = vm->top;
+            int idx;
+            save_ip();
+            /* get the builtin function 'range' */
+            idx = be_builtin_find(vm, be_newstr(vm, "range"));
+            top[0] = *be_global_var(vm, idx);
+            top[1] = *b; /* move lower to argv[0] */
+            top[2] = *c; /* move upper to argv[1] */
+            vm->top += 3; /* prevent collection results */
+            be_dofunc(vm, top, 2); /* call function 'range' */
+            vm->top -= 3;
+            reg = vm->reg;
+            *RA() = *vm->top; /* copy result to R(A) */
+            dispatch();
+        }
+        opcase(NEG): {
+            bvalue *dst = RA(), *a = RKB();
+            if (var_isint(a)) {
+                var_setint(dst, -var_toint(a));
+            } else if (var_isreal(a)) {
+                var_setreal(dst, -var_toreal(a));
+            } else if (var_isinstance(a)) {
+                save_ip();
+                opcall_block(object_unop(vm, OM_NEG, a))
+            } else {
+                save_ip();
+                unop_error(vm, "-", a);
+            }
+            dispatch();
+        }
+        opcase(FLIP): {
+            bvalue *dst = RA(), *a = RKB();
+            if (var_isint(a)) {
+                var_setint(dst, -var_toint(a));
+            } else if (var_isinstance(a)) {
+                save_ip();
+                opcall_block(object_unop(vm, OM_FLIP, a))
+            } else {
+                save_ip();
+                unop_error(vm, "~", a);
+            }
+            dispatch();
+        }
+        opcase(JMP): {
+            ip += IGET_sBx(ins);
+            if (IGET_sBx(ins) < 0) { /* loop back edge */
+                budget_check();
+                finalizer_check();
+                jit_hotspot(1);
+            }
+            dispatch();
+        }
+        opcase(JMPT): {
+            bvalue *v = RA();
+            bbool cond;
+            if (var_isbool(v)) {
+                cond = var_tobool(v);
+            } else if (var_isinstance(v)) {
+                save_ip();
+                opcall_block(object_tobool(vm, v))
+            } else {
+                cond = be_value2bool(vm, v);
+            }
+            if (cond) {
+                ip += IGET_sBx(ins);
+            }
+            dispatch();
+        }
+        opcase(JMPF): {
+            bvalue *v = RA();
+            bbool cond;
+            if (var_isbool(v)) {
+                cond = var_tobool(v);
+            } else if (var_isinstance(v)) {
+                save_ip();
+                opcall_block(object_tobool(vm, v))
+            } else {
+                cond = be_value2bool(vm, v);
+            }
+            if (!cond) {
+                ip += IGET_sBx(ins);
+            }
+            dispatch();
+        }
+        opcall: /* goto: the builtin function of OP_INTRIN is called */
+        opcase(CALL): {
+            bvalue *var;
+            int mode = 0, argc = IGET_RKB(ins), tail = IGET_RKC(ins);
+            save_ip(); /* the return address of the new frame */
+            budget_check();
+            var = RA();
+        recall: /* goto: instantiation class and call constructor */
+            switch (var_type(var)) {
+            case NOT_METHOD:
+                ++var; --argc; mode = 1;
+                goto recall;
+            case BE_CLASS:
+                tail = 0; /* the result is the instance, not of 'init' */
+                if (be_class_newobj(vm, var_toobj(var), var, ++argc)) {
+                    ++var; /* to next register */
+                    goto recall; /* call constructor */
                 }
+                reg = vm->reg;
+                dispatch();
+            case BE_CLOSURE: {
+                bvalue *v, *end;
+                bproto *proto = var2cl(var)->proto;
+                if (tail) {
+                    tail_call(vm, var, argc);
+                } else {
+                    push_closure(vm, var, proto->nstack, mode);
+                }
+                v = vm->reg + argc;
+                end = vm->reg + proto->argc;
+                for (; v <= end; ++v) {
+                    var_setnil(v);
+                }
+                goto newframe;
+            }
+            case BE_NTVCLOS: {
+                bntvclos *f = var_toobj(var);
+                push_native(vm, var, argc, mode);
+                f->f(vm); /* call C primitive function */
+                ret_native(vm);
+                reg = vm->reg;
+                dispatch();
+            }
+            case BE_NTVFUNC: {
+                bntvfunc f = var_tontvfunc(var);
+                push_native(vm, var, argc, mode);
+                f(vm); /* call C primitive function */
+                ret_native(vm);
+                reg = vm->reg;
+                dispatch();
+            }
+            case BE_LNTVFUNC: { /* no call frame is pushed */
+                blntvfunc f = var_tolntvfunc(var);
+                int base = cast_int(reg - vm->stack);
+                int top = cast_int(vm->top - vm->stack);
+                int func = cast_int(var - vm->stack);
+                int expan = argc + BE_STACK_FREE_MIN + 1;
+                if (vm->stacktop < var + expan) {
+                    be_stack_expansion(vm, expan);
+                    var = vm->stack + func;
+                }
+                vm->reg = var + 1;
+                vm->top = var + 1 + argc;
+                f(vm, var + 1, argc); /* the result is stored in var */
+                vm->reg = reg = vm->stack + base;
+                vm->top = vm->stack + top;
+                var = vm->stack + func;
+                if (mode) {
+                    var[-1] = var[0];
+                }
+                dispatch();
+            }
+            default:
+                call_error(vm, var);
+            }
+            dispatch();
+        }
+        opcase(RET): {
+            bcallframe *cf = vm->cf;
+            bvalue *ret = vm->cf->func;
+            /* copy return value */
+            if (IGET_RA(ins)) {
+                *ret = *RKB();
+            } else {
+                var_setnil(ret);
+            }
+            vm->reg = cf->reg;
+            vm->top = cf->top;
+            vm->ip = cf->ip;
+            vm->cf = --vm->calldepth ? cf - 1 : NULL;
+            if (cf->status & BASE_FRAME) { /* entrance function */
                 return;
             }
-            break;
+            if (cf->status & RESUME_FRAME) {
+                resume_op(vm); /* finish the calling instruction */
+            } else {
+                ++vm->ip; /* skip the call instruction */
+            }
+            goto newframe;
+        }
+        opcase(CLOSURE): {
+            bclosure *cl;
+            bproto *p = clos->proto->ptab[IGET_Bx(ins)];
+            if (p->closure) { /* the function has no upvalues */
+                var_setclosure(RA(), p->closure);
+                dispatch();
+            }
+            save_ip();
+            cl = be_newclosure(vm, p->nupvals);
+            cl->proto = p;
+            reg = vm->reg;
+            var_setclosure(RA(), cl);
+            be_initupvals(vm, cl);
+            /* all the instances are the same, the constant (read-only)
+             * prototypes get a new closure each time */
+            if (!p->nupvals && !gc_isconst(p)) {
+                be_gc_barrier(vm, p);
+                p->closure = cl;
+            }
+            dispatch();
+        }
+        opcase(GETMBR): {
+            bvalue *a = RA(), *b = RKB(), *c = RKC();
+            bmcache *mc = ins_cache(isKC(ins));
+            if (var_isinstance(b) && var_isstr(c)) {
+                binstance *obj = var_toobj(b), *base = cache_lookup(mc, obj);
+                if (base) {
+                    cache_member(mc, base, a);
+                } else {
+                    save_ip();
+                    mc = slow_cache(isKC(ins));
+                    obj_attribute(vm, mc, b, var_tostr(c), a);
+                }
+            } else if (var_ismodule(b) && var_isstr(c)) {
+                bmodule *module = var_toobj(b);
+                if (mc && mc->owner == gc_object(module)) {
+                    *a = mc->value;
+                } else {
+                    bstring *attr = var_tostr(c);
+                    bvalue *v = be_module_attr(module, attr);
+                    save_ip();
+                    if (v) {
+                        *a = *v;
+                        if ((mc = slow_cache(isKC(ins))) != NULL) {
+                            mc->owner = gc_object(module);
+                            mc->value = *v;
+                        }
+                    } else {
+                        vm_error(vm, "module '%s' has no attribute '%s'",
+                            be_module_name(module), str(attr));
+                    }
+                }
+            } else {
+                save_ip();
+                attribute_error(vm, "attribute", b, c);
+            }
+            dispatch();
+        }
+        opcase(GETMET): {
+            bvalue *a = RA(), *b = RKB(), *c = RKC();
+            bmcache *mc = ins_cache(isKC(ins));
+            if (var_isinstance(b) && var_isstr(c)) {
+                bvalue self = *b;
+                binstance *obj = var_toobj(b), *base = cache_lookup(mc, obj);
+                int type;
+                if (base) {
+                    type = cache_member(mc, base, a);
+                } else {
+                    save_ip();
+                    mc = slow_cache(isKC(ins));
+                    type = obj_attribute(vm, mc, b, var_tostr(c), a);
+                }
+                if (type == MT_METHOD || type == MT_PRIMMETHOD
+                        || type == MT_LPRIMMETHOD) {
+                    a[1] = self;
+                } else if (var_basetype(a) == BE_FUNCTION) {
+                    a[1] = *a;
+                    var_settype(a, NOT_METHOD);
+                } else {
+                    save_ip();
+                    vm_error(vm, "class '%s' has no method '%s'",
+                        str(be_instance_name(obj)), str(var_tostr(c)));
+                }
+            } else if (var_ismodule(b) && var_isstr(c)) {
+                bmodule *module = var_toobj(b);
+                if (mc && mc->owner == gc_object(module)) {
+                    var_settype(a, NOT_METHOD);
+                    a[1] = mc->value;
+                } else {
+                    bstring *attr = var_tostr(c);
+                    bvalue *src = be_module_attr(module, attr);
+                    save_ip();
+                    if (src) {
+                        var_settype(a, NOT_METHOD);
+                        a[1] = *src;
+                        if ((mc = slow_cache(isKC(ins))) != NULL) {
+                            mc->owner = gc_object(module);
+                            mc->value = *src;
+                        }
+                    } else {
+                        vm_error(vm, "module '%s' has no method '%s'",
+                            be_module_name(module), str(attr));
+                    }
+                }
+            } else {
+                save_ip();
+                attribute_error(vm, "method", b, c);
+            }
+            dispatch();
+        }
+        opcase(SETMBR): {
+            bvalue *a = RA(), *b = RKB(), *c = RKC();
+            bmcache *mc = ins_cache(isKB(ins));
+            if (var_isinstance(a) && var_isstr(b)) {
+                binstance *obj = var_toobj(a), *base = cache_lookup(mc, obj);
+                if (base && var_istype(&mc->value, MT_VARIABLE)) {
+                    be_gc_barrier(vm, base);
+                    base->members[var_toint(&mc->value)] = *c;
+                } else {
+                    bstring *attr = var_tostr(b);
+                    bvalue member;
+                    int depth = be_class_member(obj->class, attr, &member);
+                    save_ip();
+                    base = depth >= 0 ? be_instance_base(obj, depth) : NULL;
+                    /* not found, or the instance has an old chain */
+                    if (base ? !var_istype(&member, MT_VARIABLE)
+                             : !be_instance_setmember(vm, obj, attr, c)) {
+                        vm_error(vm, "class '%s' cannot assign to attribute '%s'",
+                            str(be_instance_name(obj)), str(attr));
+                    }
+                    if (base) {
+                        if ((mc = slow_cache(isKB(ins))) != NULL) {
+                            mc->owner = gc_object(obj->class);
+                            mc->value = member;
+                            mc->depth = depth;
+                            mc->version = be_class_version(obj->class, depth);
+                        }
+                        be_gc_barrier(vm, base);
+                        base->members[var_toint(&member)] = *c;
+                    }
+                }
+            } else {
+                save_ip();
+                attribute_error(vm, "writable attribute", a, b);
+            }
+            dispatch();
+        }
+        opcase(GETIDX): {
+            bvalue *b = RKB(), *c = RKC(), *data = builtin_data(vm, b);
+            if (data && builtin_getidx(data, c, RA())) {
+                dispatch();
+            }
+            save_ip();
+            if (var_isinstance(b)) {
+                opcall_block(object_binop(vm, OM_ITEM, b, c))
+            } else if (var_isstr(b)) {
+                bstring *s = be_strindex(vm, var_tostr(b), c);
+                reg = vm->reg;
+                var_setstr(RA(), s);
+            } else {
+                vm_error(vm,
+                    "value '%s' does not support subscriptable",
+                    be_vtype2str(b));
+            }
+            dispatch();
+        }
+        opcase(SETIDX): {
+            bvalue *a = RA(), *b = RKB(), *c = RKC(), *data = builtin_data(vm, a);
+            if (data) {
+                builtin_setidx(vm, data, b, c);
+                dispatch();
+            }
+            save_ip();
+            if (var_isinstance(a)) {
+                opcall_block(object_setidx(vm, a, b, c))
+            } else {
+                vm_error(vm,
+                    "value '%s' does not support index assignment",
+                    be_vtype2str(a));
+            }
+            dispatch();
+        }
+        opcase(SETSUPER): {
+            bvalue *a = RA(), *b = RKB();
+            if (var_isclass(a) && var_isclass(b)) {
+                bclass *obj = var_toobj(a);
+                be_class_setsuper(vm, obj, var_toobj(b));
+            } else {
+                save_ip();
+                vm_error(vm,
+                    "value '%s' does not support set super",
+                    be_vtype2str(b));
+            }
+            dispatch();
+        }
+        opcase(CLOSE): {
+            be_upvals_close(vm, RA());
+            dispatch();
+        }
+        opcase(IMPORT): {
+            bvalue *b = RKB();
+            save_ip();
+            if (var_isstr(b)) {
+                bmodule *m = be_module_load(vm, var_tostr(b), RA());
+                if (m == NULL) {
+                    vm_error(vm, "module '%s' not found",
+                        str(var_tostr(b)));
+                }
+            } else {
+                vm_error(vm,
+                    "import '%s' does not support import",
+                    be_vtype2str(b));
+            }
+            dispatch();
+        }
+        opcase(JLT): {
+            relop_rule(<, OM_LT)
+            quicken_jcmp()
+            relop_jump()
+            dispatch();
+        }
+        opcase(JLE): {
+            relop_rule(<=, OM_LE)
+            quicken_jcmp()
+            relop_jump()
+            dispatch();
+        }
+        opcase(JEQ): {
+            equal_rule(==, btrue, OM_EQ)
+            quicken_jcmp()
+            relop_jump()
+            dispatch();
+        }
+        opcase(JNE): {
+            equal_rule(!=, bfalse, OM_NE)
+            quicken_jcmp()
+            relop_jump()
+            dispatch();
+        }
+        opcase(JGT): {
+            relop_rule(>, OM_GT)
+            quicken_jcmp()
+            relop_jump()
+            dispatch();
+        }
+        opcase(JGE): {
+            relop_rule(>=, OM_GE)
+            quicken_jcmp()
+            relop_jump()
+            dispatch();
+        }
+        opcase(FORPREP): {
+            bvalue *lower = RKB(), *upper = RKC();
+            if (var_isint(lower) && var_isint(upper)) {
+                bvalue *v = RA();
+                bint a = var_toint(lower), b = var_toint(upper);
+                var_setint(v + 1, a); /* the loop counter */
+                var_setint(v + 2, b); /* the loop limit */
+                if (a <= b) {
+                    var_setint(v, a);
+                    ++ip; /* skip the exit jump */
+                }
+            } else {
+                save_ip();
+                vm_error(vm,
+                    "the range of the for-loop must be integers, "
+                    "but got '%s' and '%s'",
+                    be_vtype2str(lower), be_vtype2str(upper));
+            }
+            dispatch();
+        }
+        opcase(FORLOOP): {
+            bvalue *v = RA();
+            bint i = var_toint(v + 1);
+            if (i < var_toint(v + 2)) {
+                var_setint(v + 1, ++i);
+                var_setint(v, i);
+                ip += IGET_sBx(ins);
+                budget_check();
+                finalizer_check();
+                jit_hotspot(1);
+            }
+            dispatch();
+        }
+        opcase(ITERPREP): {
+            bvalue *v = RA();
+            if (builtin_data(vm, v)) {
+                var_setint(v + 1, -1); /* the index of the last element */
+            } else {
+                save_ip();
+                if (!call_method(vm, v, OM_ITER)) {
+                    var_setnil(vm->top);
+                }
+                reg = vm->reg;
+                *(RA() + 1) = *vm->top;
+            }
+            dispatch();
+        }
+        opcase(ITERNEXT): {
+            bvalue *v = RA(), *data = builtin_data(vm, v);
+            if (data) {
+                bvalue *next = iter_next(data, v + 1);
+                if (next) {
+                    reg[IGET_RKB(ins)] = *next;
+                    ++ip; /* skip the exit jump */
+                }
+            } else { /* call the methods 'hasnext' and 'next' */
+                save_ip();
+                if (call_method(vm, v + 1, OM_HASNEXT)) {
+                    bvalue res = *vm->top;
+                    if (be_value2bool(vm, &res)) {
+                        reg = vm->reg;
+                        if (!call_method(vm, RA() + 1, OM_NEXT)) {
+                            var_setnil(vm->top);
+                        }
+                        reg = vm->reg;
+                        reg[IGET_RKB(ins)] = *vm->top;
+                        ++ip; /* skip the exit jump */
+                    }
+                }
+                reg = vm->reg;
+            }
+            dispatch();
+        }
+        opcase(SETLIST): {
+            bvalue *v = RA(), *data = instance_data(v);
+            blist *list = var_toobj(data);
+            int i, n = IGET_RKB(ins);
+            be_assert(var_islist(data));
+            save_ip();
+            be_list_reserve(vm, list, be_list_count(list) + n);
+            for (i = 1; i <= n; ++i) {
+                be_list_append(vm, list, v + i);
+            }
+            dispatch();
+        }
+        opcase(SETMAP): {
+            bvalue *v = RA(), *data = instance_data(v);
+            bmap *map = var_toobj(data);
+            int i, n = IGET_RKB(ins);
+            be_assert(var_ismap(data));
+            save_ip();
+            be_map_reserve(vm, map, be_map_count(map) + n);
+            for (i = 1; i <= n; ++i) {
+                bvalue *k = v + i * 2 - 1;
+                /* a nil key is ignored, as by map.insert() */
+                if (!var_isnil(k)) {
+                    be_map_insert(vm, map, k, k + 1);
+                }
+            }
+            dispatch();
+        }
+        opcase(ADDINT): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(+, a, b));
+                dispatch();
+            }
+            deoptimize(OP_ADD)
+        }
+        opcase(ADDREAL): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isreal(a) && var_isreal(b)) {
+                var_setreal(dst, var_toreal(a) + var_toreal(b));
+                dispatch();
+            }
+            deoptimize(OP_ADD)
+        }
+        opcase(SUBINT): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(-, a, b));
+                dispatch();
+            }
+            deoptimize(OP_SUB)
+        }
+        opcase(SUBREAL): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isreal(a) && var_isreal(b)) {
+                var_setreal(dst, var_toreal(a) - var_toreal(b));
+                dispatch();
+            }
+            deoptimize(OP_SUB)
+        }
+        opcase(MULINT): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                var_setint(dst, ibinop(*, a, b));
+                dispatch();
+            }
+            deoptimize(OP_MUL)
+        }
+        opcase(MULREAL): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isreal(a) && var_isreal(b)) {
+                var_setreal(dst, var_toreal(a) * var_toreal(b));
+                dispatch();
+            }
+            deoptimize(OP_MUL)
+        }
+        opcase(DIVINT): { /* the division by zero is raised by OP_DIV */
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b) && var_toint(b) != 0) {
+                var_setint(dst, ibinop(/, a, b));
+                dispatch();
+            }
+            deoptimize(OP_DIV)
+        }
+        opcase(DIVREAL): {
+            bvalue *dst = RA(), *a = RKB(), *b = RKC();
+            if (var_isreal(a) && var_isreal(b) && var_toreal(b) != cast(breal, 0)) {
+                var_setreal(dst, var_toreal(a) / var_toreal(b));
+                dispatch();
+            }
+            deoptimize(OP_DIV)
+        }
+        opcase(JCMPINT): {
+            bvalue *a = RKB(), *b = RKC();
+            if (var_isint(a) && var_isint(b)) {
+                bint x = var_toint(a), y = var_toint(b);
+                int res;
+                switch (IJCMP_OP(ins)) {
+                case OP_JLT: res = x < y; break;
+                case OP_JLE: res = x <= y; break;
+                case OP_JEQ: res = x == y; break;
+                case OP_JNE: res = x != y; break;
+                case OP_JGT: res = x > y; break;
+                default: res = x >= y; break; /* OP_JGE */
+                }
+                if (res == (int)IJCMP_RA(ins)) {
+                    ip += IGET_sBx(ip[1]) + 1; /* take the jump */
+                } else {
+                    ++ip; /* skip the jump */
+                }
+                dispatch();
+            }
+            *ip = IJCMP_GENERIC(ins); /* deoptimize */
+            dispatch_current();
+        }
+        opcase(INTRIN): {
+            bvalue *v = RA();
+            save_ip(); /* str() and type() create strings */
+            if (intrinsic(vm, IGET_RKB(ins), v + 1, v)) {
+                dispatch();
+            }
+            *v = *be_global_var(vm, IGET_RKC(ins));
+            ins = ISET_OP(OP_CALL) | ISET_RA(IGET_RA(ins)) | ISET_RKB(1);
+            goto opcall;
         }
-        ++vm->ip;
     }
 }
 
@@ -842,6 +1726,14 @@ static void do_ntvfunc(bvm *vm, bvalue *reg, int argc)
     ret_native(vm);
 }
 
+static void do_lntvfunc(bvm *vm, bvalue *reg, int argc)
+{
+    blntvfunc f = var_tolntvfunc(reg);
+    push_native(vm, reg, argc, 0);
+    f(vm, vm->reg, argc); /* call C primitive function */
+    ret_native(vm);
+}
+
 static void do_class(bvm *vm, bvalue *reg, int argc)
 {
     if (be_class_newobj(vm, var_toobj(reg), reg, ++argc)) {
@@ -858,6 +1750,7 @@ void be_dofunc(bvm *vm, bvalue *v, int argc)
     case BE_CLOSURE: do_closure(vm, v, argc); break;
     case BE_NTVCLOS: do_ntvclos(vm, v, argc); break;
     case BE_NTVFUNC: do_ntvfunc(vm, v, argc); break;
+    case BE_LNTVFUNC: do_lntvfunc(vm, v, argc); break;
     default: call_error(vm, v);
     }
 }
@@ -2,6 +2,8 @@
 #define BE_VM_H
 
 #include "be_object.h"
+#include "be_class.h"
+#include "be_mem.h"
 
 typedef struct {
     struct {
@@ -23,13 +25,28 @@ typedef struct {
 } bcallframe;
 
 struct bgc {
-    bgcobject *list; /* the GC-object list */
+    bstack objects; /* the GC objects out of the GC pages (see bgcpage) */
+    bstack old; /* the old objects of the set in the generational mode */
     bgcobject *gray; /* the gray object list */
-    bgcobject *fixed; /* the fixed objecct list  */
+    bgcobject *grayagain; /* the scanned objects changed during the marking */
+    int sweep; /* the index of the next object of the set to be swept */
+    struct bgcpage *sweeppage; /* the next page to be swept */
+    bstack fixed; /* the fixed objects, they are marked as roots */
+    bstack remember; /* the old objects may refer to young objects */
+    bstack youngstr; /* the young short strings in the generational mode */
+    bstack youngpages; /* the GC pages having young objects */
+    bstack finobj; /* the instances having a finalizer */
+    bstack tobefnz; /* the unreachable instances to be finalized */
     size_t usage; /* the count of bytes currently allocated */
     size_t threshold; /* he threshold of allocation for the next GC */
+    size_t majorbase; /* the usage after the last major collection */
+    int stepsize; /* the amount of work of an incremental step */
+    int strindex; /* the next bucket of the string table to be swept */
     bbyte steprate; /* the rate of increase in the distribution between two GCs (percentage) */
     bbyte status;
+    bbyte state; /* the phase of the running collection cycle */
+    bbyte white; /* the white of the new objects */
+    bbyte sweepid; /* the id of the running sweep, see gc_pagepending() */
 };
 
 struct bstringtable {
@@ -42,9 +59,13 @@ struct bvm {
     bglobaldesc gbldesc; /* global description */
     bvalue *stack; /* stack space */
     bvalue *stacktop; /* stack top register */
-    bupval *upvalist; /* open upvalue list */
-    bstack callstack; /* function call stack */
-    bcallframe *cf; /* function call frame */
+    int stacklimit; /* maximum stack size */
+    bupval **upvaltab; /* open upvalues indexed by the stack slot */
+    int upvaltop; /* upper bound of the slots having open upvalues */
+    bcallframe *callstack; /* function call stack (frame array) */
+    bcallframe *cf; /* function call frame (top of the call stack) */
+    int calldepth; /* the count of the frames in use */
+    int callsize; /* the count of the allocated frames */
     bvalue *reg; /* function base register */
     bvalue *top; /* function top register */
     binstruction *ip; /* function instruction pointer */
@@ -52,12 +73,31 @@ struct bvm {
     bstack refstack; /* object reference stack */
     struct bmodule *modulelist;
     struct bstringtable strtab;
+    bstring *opnames[OM_COUNT]; /* the names of the operator methods */
+    unsigned int classver; /* the stamp of the last class modification */
+    bclass *listclass; /* the builtin list class, see builtin_data() */
+    bclass *mapclass; /* the builtin map class */
     struct bgc gc;
+#if BE_USE_MEM_POOL
+    struct bmempool pool; /* the allocator of the small blocks */
+#endif
+    int budget; /* the remaining execution budget, 0 means no budget */
+    bbudgethook budgethook; /* called when the budget is exhausted */
+#if BE_USE_JIT
+    void *perfmap; /* the perf map file of the native code, or NULL */
+#endif
 };
 
+#define be_callframe(vm, i)     ((vm)->callstack + (i))
+
 #define NONE_FLAG           0
 #define BASE_FRAME          (1 << 0)
 #define PRIM_FUNC           (1 << 1)
+#define RESUME_FRAME        (1 << 2) /* called by an instruction */
+
+/* the light native functions are called without pushing a frame, so
+ * one of them is running when the current frame is not PRIM_FUNC */
+#define be_inlightcall(vm)  ((vm)->cf && !((vm)->cf->status & PRIM_FUNC))
 
 #define var2cl(_v)          cast(bclosure*, var_toobj(_v))
 #define curcl(_vm)          var2cl((_vm)->cf->func)
@@ -65,14 +65,31 @@ enum berrorcode {
 #define BE_CFUNCTION            4
 #define BE_CSTRING              5
 #define BE_CMODULE              6
+#define BE_CLFUNCTION           7
 
 typedef struct bvm bvm;        /* virtual machine structure */
+struct bvalue;                 /* berry value, opaque to the API */
 typedef int (*bntvfunc)(bvm*); /* native function pointer */
 
-/* native function information */
+/* light native function pointer. the function is called without a call
+ * frame, 'argv' points to the first argument and 'argc' is the argument
+ * count. the arguments are also accessible through the stack API and the
+ * result is returned with be_return(), as in the normal native functions.
+ * 'argv' is invalid once the stack has been grown (e.g. by push or call). */
+typedef int (*blntvfunc)(bvm*, struct bvalue*, int);
+
+/* execution budget hook. be_setbudget() limits the count of the loop
+ * back edges and the function calls executed by the VM, the hook is
+ * called when the budget is exhausted and it continues the execution by
+ * setting a new budget, otherwise an error is raised */
+typedef void (*bbudgethook)(bvm*);
+
+/* native function information, the 'function' and 'lfunction' are both
+ * NULL for the member variables */
 typedef struct {
     const char *name;
     bntvfunc function;
+    blntvfunc lfunction;
 } bnfuncinfo;
 
 /* native module object node */
@@ -84,6 +101,7 @@ typedef const struct {
         breal r;
         bbool b;
         bntvfunc f;
+        blntvfunc lf;
         const char *s;
         const struct bntvmodule *m;
     } u;
@@ -113,6 +131,9 @@ typedef const struct bntvmodule {
 #define be_native_module_function(_name, _f)        \
     { .name = (_name), .type = BE_CFUNCTION, .u.f = (_f) }
 
+#define be_native_module_lfunction(_name, _f)       \
+    { .name = (_name), .type = BE_CLFUNCTION, .u.lf = (_f) }
+
 #define be_native_module_str(_name, _s)             \
     { .name = (_name), .type = BE_CSTRING, .u.s = (_s) }
 
@@ -204,6 +225,7 @@ const char* be_pushfstring(bvm *vm, const char *format, ...);
 void be_pushvalue(bvm *vm, int index);
 void be_pushntvclosure(bvm *vm, bntvfunc f, int nupvals);
 void be_pushntvfunction(bvm *vm, bntvfunc f);
+void be_pushlntvfunction(bvm *vm, blntvfunc f);
 void be_pushclass(bvm *vm, const char *name, const bnfuncinfo *lib);
 void be_pushcomptr(bvm *vm, void *ptr);
 int be_pushiter(bvm *vm, int index);
@@ -232,6 +254,9 @@ int be_refcontains(bvm *vm, int index);
 void be_refpush(bvm *vm, int index);
 void be_refpop(bvm *vm);
 void be_stack_require(bvm *vm, int count);
+void be_setstacklimit(bvm *vm, int size);
+void be_setbudget(bvm *vm, int count, bbudgethook hook);
+void be_mempool_stat(bvm *vm, size_t *slabsize, size_t *usedsize);
 
 int be_returnvalue(bvm *vm);
 int be_returnnilvalue(bvm *vm);
@@ -241,6 +266,7 @@ void be_abort(void);
 void be_exit(bvm *vm, int status);
 
 void be_regfunc(bvm *vm, const char *name, bntvfunc f);
+void be_reglfunc(bvm *vm, const char *name, blntvfunc f);
 void be_regclass(bvm *vm, const char *name, const bnfuncinfo *lib);
 
 bvm* be_vm_new(void);
@@ -0,0 +1,84 @@
+/* the test runner, it runs each test script in a new VM. the VM limits
+ * are only exposed to the scripts by this host, so the scripts run by
+ * the interpreter cannot change them */
+#include "berry.h"
+#include <stdio.h>
+
+/* call the function at argument 1 with the other arguments in protected
+ * mode. return nil when it succeeds, otherwise the error message. */
+static int m_pcall(bvm *vm)
+{
+    int argc = be_top(vm);
+    if (argc >= 1 && be_isfunction(vm, 1)) {
+        if (be_pcall(vm, argc - 1)) {
+            be_return(vm);
+        }
+    }
+    be_return_nil(vm);
+}
+
+static int m_setstacklimit(bvm *vm)
+{
+    if (be_top(vm) >= 1 && be_isint(vm, 1)) {
+        be_setstacklimit(vm, be_toint(vm, 1));
+    }
+    be_return_nil(vm);
+}
+
+/* the budget is cleared when it is exhausted, an error is then raised */
+static int m_setbudget(bvm *vm)
+{
+    if (be_top(vm) >= 1 && be_isint(vm, 1)) {
+        be_setbudget(vm, be_toint(vm, 1), NULL);
+    }
+    be_return_nil(vm);
+}
+
+/* get [slabsize, usedsize] of the memory pool, both are 0 when the
+ * pool is not used */
+static int m_poolstat(bvm *vm)
+{
+    size_t slabsize, usedsize;
+    be_mempool_stat(vm, &slabsize, &usedsize);
+    be_getbuiltin(vm, "list");
+    be_newlist(vm);
+    be_pushint(vm, (bint)slabsize);
+    be_data_append(vm, -2);
+    be_pop(vm, 1);
+    be_pushint(vm, (bint)usedsize);
+    be_data_append(vm, -2);
+    be_pop(vm, 1);
+    be_call(vm, 1);
+    be_pop(vm, 1);
+    be_return(vm);
+}
+
+/* run a test script, the result is 0 if it succeeds */
+static int dotest(const char *name)
+{
+    bvm *vm = be_vm_new();
+    int res;
+    be_regfunc(vm, "pcall", m_pcall);
+    be_regfunc(vm, "setstacklimit", m_setstacklimit);
+    be_regfunc(vm, "setbudget", m_setbudget);
+    be_regfunc(vm, "poolstat", m_poolstat);
+    res = be_loadfile(vm, name);
+    res = res == BE_OK ? be_pcall(vm, 0) : res;
+    if (res != BE_OK) {
+        printf("[failed] %s: %s\n", name,
+            res == BE_MALLOC_FAIL ? "memory allocation failed" : be_tostring(vm, -1));
+    }
+    be_vm_delete(vm);
+    return res != BE_OK;
+}
+
+/* runner script1 [script2 ...] */
+int main(int argc, char *argv[])
+{
+    int i, failed = 0;
+    for (i = 1; i < argc; ++i) {
+        failed += dotest(argv[i]);
+    }
+    printf("%d tests, %d failed\n", argc - 1, failed);
+    return failed != 0;
+}